@@ -0,0 +1,85 @@
+#include "harness.hpp"
+#include "lua_allocator.hpp"
+
+namespace {
+
+constexpr std::size_t num_objects = 10000;
+
+// Tables, strings and closures, the typical garbage of scripts
+constexpr auto workload = R"(
+  local objects = {}
+  for i = 1, num_objects do
+    local name = 'object_' .. i
+    objects[i % 64 + 1] = {
+      name = name, x = i, y = -i,
+      update = function(self, dt) self.x = self.x + dt end
+    }
+  end
+)";
+
+// Default allocator (realloc) that tracks used memory
+class tracking_allocator {
+public:
+  static void *alloc(void *ud, void *ptr, std::size_t osize,
+                     std::size_t nsize) {
+    auto &self = *static_cast<tracking_allocator *>(ud);
+    if (!ptr) osize = 0;
+    self.m_used = self.m_used - osize + nsize;
+    self.m_peak = std::max(self.m_peak, self.m_used);
+    if (nsize == 0) {
+      std::free(ptr);
+      return nullptr;
+    }
+    return std::realloc(ptr, nsize);
+  }
+
+  [[nodiscard]] std::size_t peak() const { return m_peak; }
+
+private:
+  std::size_t m_used{0};
+  std::size_t m_peak{0};
+};
+
+// Counts allocations the same way as bench::lua_alloc
+template <typename Allocator>
+void *counted_alloc(void *ud, void *ptr, std::size_t osize, std::size_t nsize) {
+  if (nsize > 0 && (!ptr || nsize > osize)) ++bench::num_allocations;
+  return Allocator::alloc(ud, ptr, osize, nsize);
+}
+
+// One operation = one object (table + string + closure), every repetition
+// runs in a fresh state (and allocator), peak = memory taken from the system
+// (before the state is closed)
+template <typename Allocator, typename Footprint>
+void run_workload(bench::context &ctx, Footprint footprint) {
+  std::size_t peak{0};
+  ctx.measure(num_objects, [&] {
+    Allocator allocator{};
+    {
+      auto lua = bench::make_state(&counted_alloc<Allocator>, &allocator);
+      lua["num_objects"] = num_objects;
+      lua.script(workload);
+      peak = std::max(peak, footprint(allocator));
+    }
+  });
+  ctx.report_peak(peak);
+}
+
+} // namespace
+
+void register_allocator_benchmarks(bench::suite &suite) {
+  const auto suffix = "/" + std::to_string(num_objects);
+
+  suite.add("allocator/default" + suffix, [](bench::context &ctx) {
+    run_workload<tracking_allocator>(
+      ctx, [](const tracking_allocator &a) { return a.peak(); });
+  });
+  suite.add("allocator/pool" + suffix, [](bench::context &ctx) {
+    run_workload<pool_allocator>(
+      ctx, [](const pool_allocator &a) { return a.reserved(); });
+  });
+  suite.add("allocator/arena" + suffix, [](bench::context &ctx) {
+    run_workload<arena_allocator>(
+      ctx, [](const arena_allocator &a) { return a.reserved(); });
+  });
+}
@@ -0,0 +1,116 @@
+#include "harness.hpp"
+#include "../examples/dispatcher/bond.hpp"
+
+#define AUTO_ARG(x) decltype(x), x
+
+namespace {
+
+constexpr std::size_t num_ops = 1000;
+
+struct TestEvent {
+  std::string origin;
+  int value{-1};
+};
+
+[[nodiscard]] sol::state make_dispatcher_state(entt::dispatcher &dispatcher) {
+  register_meta_event<TestEvent>();
+
+  auto lua = bench::make_state();
+  lua.require("dispatcher", sol::c_call<AUTO_ARG(&open_dispatcher)>, false);
+  // clang-format off
+  lua.new_usertype<TestEvent>("TestEvent",
+    "type_id", &entt::type_hash<TestEvent>::value,
+    sol::call_constructor,
+    sol::factories([](const char *origin, int value) {
+      return TestEvent{origin, value};
+    }),
+    "origin", &TestEvent::origin,
+    "value", &TestEvent::value
+  );
+  // clang-format on
+  stamp_type_id<TestEvent>(lua["TestEvent"]);
+  lua.script_file("lua/define_event.lua");
+  lua.script("Foo = define_event()\n"
+             "Pooled = define_event({ pooled = true })\n"
+             "function make_pooled(value)\n"
+             "  local evt = Pooled()\n"
+             "  evt.value = value\n"
+             "  return evt\n"
+             "end\n"
+             "Values = define_event({ values = true })");
+  lua["dispatcher"] = std::ref(dispatcher);
+  return lua;
+}
+
+// 'event' is one of: TestEvent (native), Foo (scripted), Pooled, Values
+// 'connect' is either connect or connect_batch
+void measure_dispatch(bench::context &ctx, std::size_t num_listeners,
+                      const std::string &event, const std::string &body,
+                      const std::string &connect = "connect") {
+  entt::dispatcher dispatcher{};
+  auto lua = make_dispatcher_state(dispatcher);
+
+  lua["num_listeners"] = num_listeners;
+  lua.script("connections = {}\n"
+             "for i = 1, num_listeners do\n"
+             "  connections[i] = dispatcher:" +
+             connect + "(" + event + ", function(evt) end)\n"
+             "end");
+
+  auto f = bench::compile(lua, "local dispatcher, n = ...\n" + body);
+  ctx.measure(num_ops, [&] { f(std::ref(dispatcher), num_ops); });
+
+  lua.script("connections = nil");
+  lua.collect_garbage();
+}
+
+} // namespace
+
+void register_dispatcher_benchmarks(bench::suite &suite) {
+  struct {
+    const char *kind;
+    const char *event;
+    const char *trigger;
+    const char *enqueue;
+  } const variants[]{
+    {"native", "TestEvent", "dispatcher:trigger(TestEvent('lua', i))",
+     "dispatcher:enqueue(TestEvent('lua', i))"},
+    {"scripted", "Foo", "dispatcher:trigger(Foo({ value = i }))",
+     "dispatcher:enqueue(Foo({ value = i }))"},
+    {"pooled", "Pooled", "dispatcher:trigger(make_pooled(i))",
+     "dispatcher:enqueue(make_pooled(i))"},
+    {"values", "Values", "dispatcher:trigger_values(Values, i)",
+     "dispatcher:enqueue_values(Values, i)"},
+  };
+  for (const auto &variant : variants) {
+    for (std::size_t num_listeners : {1, 10, 100}) {
+      const auto suffix = "/" + std::string{variant.kind} + "/" +
+                          std::to_string(num_listeners);
+
+      suite.add("dispatcher/trigger" + suffix, [=](bench::context &ctx) {
+        measure_dispatch(ctx, num_listeners, variant.event,
+                         "for i = 1, n do " + std::string{variant.trigger} +
+                           " end");
+      });
+      suite.add("dispatcher/enqueue+update" + suffix,
+                [=](bench::context &ctx) {
+                  measure_dispatch(ctx, num_listeners, variant.event,
+                                   "for i = 1, n do " +
+                                     std::string{variant.enqueue} +
+                                     " end\n"
+                                     "dispatcher:update()");
+                });
+      // Values can't be batched
+      if (std::string_view{variant.kind} == "values") continue;
+      suite.add("dispatcher/enqueue+update_batch" + suffix,
+                [=](bench::context &ctx) {
+                  measure_dispatch(ctx, num_listeners, variant.event,
+                                   "for i = 1, n do " +
+                                     std::string{variant.enqueue} +
+                                     " end\n"
+                                     "dispatcher:update()",
+                                   "connect_batch");
+                });
+    }
+  }
+}
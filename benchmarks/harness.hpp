@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "sol/sol.hpp"
+
+namespace bench {
+
+// Incremented by global operator new (see main.cpp) and by lua_alloc.
+inline std::atomic<std::size_t> num_allocations{0};
+
+// Same as the default allocator of sol::state, but counts allocations.
+inline void *lua_alloc(void *, void *ptr, std::size_t osize,
+                       std::size_t nsize) {
+  if (nsize == 0) {
+    std::free(ptr);
+    return nullptr;
+  }
+  if (!ptr || nsize > osize) ++num_allocations;
+  return std::realloc(ptr, nsize);
+}
+
+// sol::state with counted allocations (unless a custom allocator is given).
+[[nodiscard]] inline sol::state make_state(lua_Alloc alloc = &lua_alloc,
+                                           void *ud = nullptr) {
+  sol::state lua{sol::default_at_panic, alloc, ud};
+  lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::string,
+                     sol::lib::table, sol::lib::math);
+  return lua;
+}
+[[nodiscard]] inline sol::function compile(sol::state &lua,
+                                           const std::string &code) {
+  auto chunk = lua.load(code);
+  if (!chunk.valid()) {
+    const sol::error err = chunk;
+    throw std::runtime_error{err.what()};
+  }
+  return chunk.get<sol::function>();
+}
+
+// Silences std::cout (e.g. logging of bindings) for its lifetime.
+class mute_stdout {
+public:
+  mute_stdout() : m_buffer{std::cout.rdbuf(nullptr)} {}
+  mute_stdout(const mute_stdout &) = delete;
+  ~mute_stdout() { std::cout.rdbuf(m_buffer); }
+
+  mute_stdout &operator=(const mute_stdout &) = delete;
+
+private:
+  std::streambuf *m_buffer;
+};
+
+struct result {
+  std::string name;
+  std::size_t ops;
+  double ns_per_op;
+  double allocs_per_op;
+  std::size_t peak_bytes{0}; // Optional, @see context::report_peak
+};
+
+class context {
+public:
+  context(std::string name, std::chrono::nanoseconds min_time,
+          std::vector<result> &results)
+      : m_name{std::move(name)}, m_min_time{min_time}, m_results{results} {}
+
+  // Repeats func (which performs ops operations) for at least min_time.
+  template <typename Func> void measure(std::size_t ops, Func &&func) {
+    using clock = std::chrono::steady_clock;
+
+    func(); // Warm-up
+
+    std::size_t repetitions{0};
+    const auto allocations_before = num_allocations.load();
+    const auto begin_ticks = clock::now();
+    auto elapsed = clock::duration{0};
+    do {
+      func();
+      ++repetitions;
+      elapsed = clock::now() - begin_ticks;
+    } while (elapsed < m_min_time);
+    const auto allocations = num_allocations.load() - allocations_before;
+
+    const auto total_ops = static_cast<double>(ops * repetitions);
+    m_results.push_back({
+      m_name,
+      ops * repetitions,
+      std::chrono::duration<double, std::nano>(elapsed).count() / total_ops,
+      static_cast<double>(allocations) / total_ops,
+    });
+  }
+
+  // Peak memory footprint of the last measurement
+  void report_peak(std::size_t bytes) {
+    if (!m_results.empty()) m_results.back().peak_bytes = bytes;
+  }
+
+private:
+  const std::string m_name;
+  const std::chrono::nanoseconds m_min_time;
+  std::vector<result> &m_results;
+};
+
+class suite {
+public:
+  using body = std::function<void(context &)>;
+
+  void add(std::string name, body f) {
+    m_benchmarks.emplace_back(std::move(name), std::move(f));
+  }
+
+  // Options:
+  //  --filter <substring>  run only matching benchmarks
+  //  --min-time <ms>       minimal measured time of each benchmark
+  //  --json <path>         write results as JSON
+  //  --csv <path>          write results as CSV
+  int run(int argc, char *argv[]) {
+    std::string filter, json_path, csv_path;
+    std::chrono::milliseconds min_time{250};
+    for (int i = 1; i + 1 < argc; i += 2) {
+      const std::string_view option{argv[i]};
+      if (option == "--filter") {
+        filter = argv[i + 1];
+      } else if (option == "--min-time") {
+        min_time = std::chrono::milliseconds{std::atoi(argv[i + 1])};
+      } else if (option == "--json") {
+        json_path = argv[i + 1];
+      } else if (option == "--csv") {
+        csv_path = argv[i + 1];
+      } else {
+        std::cerr << "unknown option: " << option << std::endl;
+        return -1;
+      }
+    }
+
+    std::vector<result> results;
+    for (auto &[name, f] : m_benchmarks) {
+      if (!filter.empty() && name.find(filter) == std::string::npos)
+        continue;
+
+      const auto first = results.size();
+      context ctx{name, min_time, results};
+      {
+        mute_stdout _;
+        f(ctx);
+      }
+      for (auto i = first; i < results.size(); ++i)
+        _print(std::cout, results[i]);
+    }
+
+    if (!json_path.empty()) _write_json(json_path, results);
+    if (!csv_path.empty()) _write_csv(csv_path, results);
+    return 0;
+  }
+
+private:
+  static void _print(std::ostream &os, const result &r) {
+    os << std::left << std::setw(48) << r.name << std::right << std::fixed
+       << std::setprecision(2) << std::setw(14) << r.ns_per_op << " ns/op"
+       << std::setw(12) << r.allocs_per_op << " allocs/op";
+    if (r.peak_bytes > 0)
+      os << std::setw(12) << r.peak_bytes / 1024 << " KiB peak";
+    os << std::endl;
+  }
+  static void _write_json(const std::string &path,
+                          const std::vector<result> &results) {
+    std::ofstream f{path};
+    f << "[\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      const auto &r = results[i];
+      f << "  {\"name\": \"" << r.name << "\", \"ops\": " << r.ops
+        << ", \"ns_per_op\": " << r.ns_per_op
+        << ", \"allocs_per_op\": " << r.allocs_per_op
+        << ", \"peak_bytes\": " << r.peak_bytes << "}"
+        << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    f << "]\n";
+  }
+  static void _write_csv(const std::string &path,
+                         const std::vector<result> &results) {
+    std::ofstream f{path};
+    f << "name,ops,ns_per_op,allocs_per_op,peak_bytes\n";
+    for (const auto &r : results) {
+      f << r.name << "," << r.ops << "," << r.ns_per_op << ","
+        << r.allocs_per_op << "," << r.peak_bytes << "\n";
+    }
+  }
+
+private:
+  std::vector<std::pair<std::string, body>> m_benchmarks;
+};
+
+} // namespace bench
@@ -0,0 +1,31 @@
+#include "harness.hpp"
+#include <new>
+
+// Counts every allocation made by c++ code (Lua uses bench::lua_alloc)
+void *operator new(std::size_t size) {
+  ++bench::num_allocations;
+  if (auto *ptr = std::malloc(size ? size : 1); ptr) return ptr;
+  throw std::bad_alloc{};
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+void register_allocator_benchmarks(bench::suite &);
+void register_registry_benchmarks(bench::suite &);
+void register_dispatcher_benchmarks(bench::suite &);
+void register_scheduler_benchmarks(bench::suite &);
+
+// Usage: bench [--filter name] [--min-time ms] [--json path] [--csv path]
+int main(int argc, char *argv[]) {
+  try {
+    bench::suite suite{};
+    register_allocator_benchmarks(suite);
+    register_registry_benchmarks(suite);
+    register_dispatcher_benchmarks(suite);
+    register_scheduler_benchmarks(suite);
+    return suite.run(argc, argv);
+  } catch (const std::exception &e) {
+    std::cout << "exception: " << e.what();
+    return -1;
+  }
+}
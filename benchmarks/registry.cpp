@@ -0,0 +1,208 @@
+#include <utility>
+#include "harness.hpp"
+#include "../examples/registry/bond.hpp"
+#include "../examples/common/transform.hpp"
+#include "../examples/common/velocity.hpp"
+
+#define AUTO_ARG(x) decltype(x), x
+
+namespace {
+
+constexpr std::size_t num_ops = 1000;
+
+// Used to measure multi-type calls (any_of)
+template <std::size_t N> struct Tag {
+  int value;
+};
+template <std::size_t N> void register_tag(sol::state &lua) {
+  register_meta_component<Tag<N>>();
+
+  const auto name = "Tag" + std::to_string(N);
+  // clang-format off
+  lua.new_usertype<Tag<N>>(name,
+    "type_id", &entt::type_hash<Tag<N>>::value,
+    sol::call_constructor,
+    sol::factories([] { return Tag<N>{}; }),
+    "value", &Tag<N>::value
+  );
+  // clang-format on
+  stamp_type_id<Tag<N>>(lua[name]);
+}
+template <std::size_t... Is>
+void register_tags(sol::state &lua, std::index_sequence<Is...>) {
+  (register_tag<Is>(lua), ...);
+}
+
+[[nodiscard]] sol::state make_registry_state(entt::registry &registry) {
+  register_meta_component<Transform>();
+  register_meta_data<Transform, &Transform::x>("x");
+  register_meta_data<Transform, &Transform::y>("y");
+  register_meta_kernel<&translate, Transform>("translate");
+  register_meta_component<Velocity>();
+  register_meta_group<Velocity>("movement", entt::get<Transform>);
+
+  auto lua = bench::make_state();
+  lua.require("registry", sol::c_call<AUTO_ARG(&open_registry)>, false);
+  register_transform(lua);
+  register_velocity(lua);
+  register_tags(lua, std::make_index_sequence<8>{});
+  lua["registry"] = std::ref(registry);
+  return lua;
+}
+
+// Runs 'body' (with 'registry' and 'entity' in scope) n times.
+void measure_loop(bench::context &ctx, const std::string &body) {
+  entt::registry registry{};
+  auto lua = make_registry_state(registry);
+  const auto entity = registry.create();
+  registry.emplace<Transform>(entity, 1, 2);
+
+  auto f = bench::compile(lua, "local registry, entity, n = ...\n"
+                               "for i = 1, n do " +
+                                 body + " end");
+  ctx.measure(num_ops, [&] { f(std::ref(registry), entity, num_ops); });
+}
+
+void measure_view(bench::context &ctx, std::size_t num_entities,
+                  std::size_t ops, const std::string &code) {
+  entt::registry registry{};
+  auto lua = make_registry_state(registry);
+  for (std::size_t i = 0; i < num_entities; ++i) {
+    registry.emplace<Transform>(registry.create(), 1, 2);
+  }
+  auto f = bench::compile(lua, code);
+  ctx.measure(ops, [&] { f(std::ref(registry)); });
+}
+
+// Every other entity moves (has Velocity)
+void measure_movement(bench::context &ctx, std::size_t num_entities,
+                      const std::string &code) {
+  entt::registry registry{};
+  auto lua = make_registry_state(registry);
+  for (std::size_t i = 0; i < num_entities * 2; ++i) {
+    const auto entity = registry.create();
+    registry.emplace<Transform>(entity, 1, 2);
+    if (i % 2 == 0) registry.emplace<Velocity>(entity, 1, 0);
+  }
+  auto f = bench::compile(lua, code);
+  ctx.measure(num_entities, [&] { f(std::ref(registry)); });
+}
+
+} // namespace
+
+void register_registry_benchmarks(bench::suite &suite) {
+  suite.add("registry/emplace", [](bench::context &ctx) {
+    measure_loop(ctx, "registry:emplace(entity, Transform(i, i))");
+  });
+  suite.add("registry/get", [](bench::context &ctx) {
+    measure_loop(ctx, "registry:get(entity, Transform)");
+  });
+  // A new component (address) every time, misses the proxy cache
+  suite.add("registry/get/miss", [](bench::context &ctx) {
+    measure_loop(ctx, "registry:get(registry:create(), Transform)");
+  });
+  suite.add("registry/has", [](bench::context &ctx) {
+    measure_loop(ctx, "registry:has(entity, Transform)");
+  });
+  suite.add("registry/emplace+remove", [](bench::context &ctx) {
+    measure_loop(ctx, "registry:emplace(entity, Tag0()) "
+                      "registry:remove(entity, Tag0)");
+  });
+
+  for (auto num_types : {1, 4, 8}) {
+    std::string types;
+    for (auto i = 0; i < num_types; ++i) {
+      types += ", Tag" + std::to_string(i);
+    }
+    suite.add("registry/any_of/" + std::to_string(num_types),
+              [types](bench::context &ctx) {
+                measure_loop(ctx, "registry:any_of(entity" + types + ")");
+              });
+    suite.add("registry/all_of/" + std::to_string(num_types),
+              [types](bench::context &ctx) {
+                measure_loop(ctx, "registry:all_of(entity" + types + ")");
+              });
+  }
+
+  for (std::size_t num_entities : {1'000, 100'000, 1'000'000}) {
+    const auto suffix = "/" + std::to_string(num_entities);
+    // Construction does not depend on number of entities, but on storages
+    suite.add("runtime_view/construct" + suffix,
+              [num_entities](bench::context &ctx) {
+                measure_view(ctx, num_entities, 1,
+                             "local registry = ...\n"
+                             "registry:runtime_view(Transform)");
+              });
+    suite.add("runtime_view/each" + suffix,
+              [num_entities](bench::context &ctx) {
+                measure_view(ctx, num_entities, num_entities,
+                             "local registry = ...\n"
+                             "registry:runtime_view(Transform):each("
+                             "function(entity) end)");
+              });
+    suite.add("query/each" + suffix, [num_entities](bench::context &ctx) {
+      measure_view(ctx, num_entities, num_entities,
+                   "local registry = ...\n"
+                   "registry:query(Transform):each("
+                   "function(entity, transform) end)");
+    });
+    // Same work (one field of each Transform), proxy vs column
+    suite.add("query/each+field" + suffix,
+              [num_entities](bench::context &ctx) {
+                measure_view(ctx, num_entities, num_entities,
+                             "local registry = ...\n"
+                             "registry:query(Transform):each("
+                             "function(entity, transform) "
+                             "transform.x = transform.x + 1 end)");
+              });
+    suite.add("column/field" + suffix, [num_entities](bench::context &ctx) {
+      measure_view(ctx, num_entities, num_entities,
+                   "local registry = ...\n"
+                   "local x = registry:column(Transform, 'x')\n"
+                   "for i = 1, #x do x[i] = x[i] + 1 end");
+    });
+    suite.add("kernel/translate" + suffix,
+              [num_entities](bench::context &ctx) {
+                measure_view(ctx, num_entities, num_entities,
+                             "local registry = ...\n"
+                             "registry:apply('translate', {Transform}, 1, 0)");
+              });
+    // One operation = one moving entity, query vs owning group
+    suite.add("query/movement" + suffix, [num_entities](bench::context &ctx) {
+      measure_movement(ctx, num_entities,
+                       "local registry = ...\n"
+                       "registry:query(Velocity, Transform):each("
+                       "function(entity, velocity, transform) "
+                       "transform.x = transform.x + velocity.x end)");
+    });
+    suite.add("group/movement" + suffix, [num_entities](bench::context &ctx) {
+      measure_movement(ctx, num_entities,
+                       "local registry = ...\n"
+                       "registry:group('movement'):each("
+                       "function(entity, velocity, transform) "
+                       "transform.x = transform.x + velocity.x end)");
+    });
+    // One operation = one entity (with Transform), through a file
+    suite.add("snapshot/save" + suffix, [num_entities](bench::context &ctx) {
+      entt::registry registry{};
+      auto lua = make_registry_state(registry);
+      for (std::size_t i = 0; i < num_entities; ++i)
+        registry.emplace<Transform>(registry.create(), 1, 2);
+
+      ctx.measure(num_entities,
+                  [&] { save_snapshot(registry, "bench.snapshot"); });
+    });
+    suite.add("snapshot/load" + suffix, [num_entities](bench::context &ctx) {
+      entt::registry registry{};
+      auto lua = make_registry_state(registry);
+      for (std::size_t i = 0; i < num_entities; ++i)
+        registry.emplace<Transform>(registry.create(), 1, 2);
+      save_snapshot(registry, "bench.snapshot");
+
+      ctx.measure(num_entities, [&] {
+        entt::registry restored{};
+        load_snapshot(restored, "bench.snapshot", lua);
+      });
+    });
+  }
+}
@@ -0,0 +1,107 @@
+#include <cstdint>
+#include "harness.hpp"
+#include "../examples/scheduler/bond.hpp"
+
+#define AUTO_ARG(x) decltype(x), x
+
+namespace {
+
+constexpr std::size_t num_processes = 1000;
+constexpr std::size_t num_idle_processes = 10000;
+
+template <typename Scheduler>
+void attach_processes(sol::state &lua, Scheduler &scheduler,
+                      std::size_t count) {
+  lua["scheduler"] = std::ref(scheduler);
+  lua["num_processes"] = count;
+  lua.script("for i = 1, num_processes do\n"
+             "  scheduler:attach({ update = function(self, dt) end })\n"
+             "end");
+}
+
+// Fixed amount of work per tick, never finishes
+class spin_process : public entt::process<spin_process, fsec> {
+public:
+  void update(fsec, void *) {
+    for (auto i = 0; i < 10'000; ++i)
+      m_state = m_state * 1664525u + 1013904223u;
+  }
+
+private:
+  std::uint32_t m_state{1};
+};
+
+constexpr std::size_t num_native_processes = 256;
+
+} // namespace
+
+void register_scheduler_benchmarks(bench::suite &suite) {
+  suite.add("scheduler/update/" + std::to_string(num_processes),
+            [](bench::context &ctx) {
+              auto lua = bench::make_state();
+              lua.require("scheduler", sol::c_call<AUTO_ARG(&open_scheduler)>,
+                          false);
+
+              scheduler scheduler{};
+              attach_processes(lua, scheduler, num_processes);
+
+              // One operation = one process updated
+              const fsec delta_time{std::chrono::milliseconds{16}};
+              ctx.measure(num_processes,
+                          [&] { scheduler.update(delta_time); });
+
+              scheduler.clear();
+            });
+
+  // Processes are updated every 250 ms, one operation = one frame (16 ms)
+  suite.add("scheduler/frame/" + std::to_string(num_idle_processes),
+            [](bench::context &ctx) {
+              auto lua = bench::make_state();
+              lua.require("scheduler", sol::c_call<AUTO_ARG(&open_scheduler)>,
+                          false);
+
+              scheduler scheduler{};
+              attach_processes(lua, scheduler, num_idle_processes);
+
+              const fsec delta_time{std::chrono::milliseconds{16}};
+              ctx.measure(1, [&] { scheduler.update(delta_time); });
+
+              scheduler.clear();
+            });
+  // One operation = one native process updated, serial vs parallel
+  suite.add("scheduler/native/" + std::to_string(num_native_processes),
+            [](bench::context &ctx) {
+              scheduler scheduler{};
+              for (std::size_t i = 0; i < num_native_processes; ++i)
+                scheduler.attach<spin_process>();
+
+              const fsec delta_time{std::chrono::milliseconds{16}};
+              ctx.measure(num_native_processes,
+                          [&] { scheduler.update(delta_time); });
+            });
+  suite.add("parallel_scheduler/native/" +
+              std::to_string(num_native_processes),
+            [](bench::context &ctx) {
+              parallel_scheduler scheduler{};
+              for (std::size_t i = 0; i < num_native_processes; ++i)
+                scheduler.attach<spin_process>();
+
+              const fsec delta_time{std::chrono::milliseconds{16}};
+              ctx.measure(num_native_processes,
+                          [&] { scheduler.update(delta_time); });
+            });
+  suite.add("wheel_scheduler/frame/" + std::to_string(num_idle_processes),
+            [](bench::context &ctx) {
+              auto lua = bench::make_state();
+              lua.require("scheduler", sol::c_call<AUTO_ARG(&open_scheduler)>,
+                          false);
+
+              wheel_scheduler scheduler{};
+              attach_processes(lua, scheduler, num_idle_processes);
+
+              const fsec delta_time{std::chrono::milliseconds{16}};
+              ctx.measure(1, [&] { scheduler.update(delta_time); });
+
+              scheduler.clear();
+            });
+}
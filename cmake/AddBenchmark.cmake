@@ -0,0 +1,13 @@
+function(ADD_BENCHMARK)
+  cmake_parse_arguments(PARSE_ARGV 0 ARGS "" "TARGET" "SOURCES")
+
+  add_executable(${ARGS_TARGET} ${ARGS_SOURCES})
+  target_link_libraries(${ARGS_TARGET} PUBLIC EnTT::EnTT sol2 MetaHelper)
+  add_dependencies(${ARGS_TARGET} CopyScripts)
+
+  set_property(
+    TARGET ${ARGS_TARGET}
+    PROPERTY VS_DEBUGGER_WORKING_DIRECTORY
+    "${CMAKE_RUNTIME_OUTPUT_DIRECTORY}")
+  set_property(TARGET ${ARGS_TARGET} PROPERTY FOLDER "Benchmarks")
+endfunction()
@@ -1,5 +1,5 @@
 function(ADD_SCRIPTS)
-  cmake_parse_arguments(PARSE_ARGV 0 ARGS "" "TARGET;DIR" "")
+  cmake_parse_arguments(PARSE_ARGV 0 ARGS "" "TARGET;DIR;PACK" "")
 
   file(GLOB_RECURSE SCRIPT_FILES "${ARGS_DIR}/*.*")
 
@@ -17,7 +17,25 @@ function(ADD_SCRIPTS)
       COMMENT "Copying script: ${FILENAME}")
 
     list(APPEND OUT_FILES ${OUT_FILE})
+    if(FILENAME MATCHES "\\.lua$")
+      list(APPEND LUA_FILES ${OUT_FILE})
+      list(APPEND LUA_NAMES "lua/${FILENAME}")
+    endif()
   endforeach()
 
+  # Bytecode of copied scripts (names relative to the runtime output dir)
+  # @see utility/script_pack.hpp
+  if(ARGS_PACK)
+    set(PACK_FILE "${CMAKE_RUNTIME_OUTPUT_DIRECTORY}/${ARGS_PACK}")
+    add_custom_command(
+      OUTPUT ${PACK_FILE}
+      COMMAND luapack ${PACK_FILE} ${LUA_NAMES}
+      WORKING_DIRECTORY "${CMAKE_RUNTIME_OUTPUT_DIRECTORY}"
+      DEPENDS luapack ${LUA_FILES}
+      COMMENT "Precompiling scripts: ${ARGS_PACK}")
+
+    list(APPEND OUT_FILES ${PACK_FILE})
+  endif()
+
   add_custom_target(CopyScripts DEPENDS ${OUT_FILES})
 endfunction()
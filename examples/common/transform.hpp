@@ -1,6 +1,10 @@
 #pragma once
 
 #include <sstream>
+#include <string>
+#include "entt/entity/view.hpp"
+#include "meta_helper.hpp"
+#include "sol/sol.hpp"
 
 struct Transform {
   // https://github.com/skypjack/entt/wiki/Crash-Course:-entity-component-system#pointer-stability
@@ -15,7 +19,18 @@ struct Transform {
   }
 };
 
-void register_transform(sol::state &lua) {
+// Kernel, in lua: registry:apply("translate", {Transform}, dx, dy)
+inline void translate(entt::view<entt::get_t<Transform>> view,
+               const sol::variadic_args &args) {
+  const auto dx = args.get<int>(0);
+  const auto dy = args.get<int>(1);
+  for (auto &&[entity, transform] : view.each()) {
+    transform.x += dx;
+    transform.y += dy;
+  }
+}
+
+inline void register_transform(sol::state &lua) {
   // clang-format off
   lua.new_usertype<Transform>("Transform",
     "type_id", &entt::type_hash<Transform>::value,
@@ -30,4 +45,5 @@ void register_transform(sol::state &lua) {
     sol::meta_function::to_string, &Transform::to_string
   );
   // clang-format on
+  stamp_type_id<Transform>(lua["Transform"]);
 }
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+#include "meta_helper.hpp"
+#include "sol/sol.hpp"
+
+// Without pointer stability, so it can be owned by a group
+// (see register_meta_group)
+struct Velocity {
+  int x, y;
+
+  [[nodiscard]] std::string to_string() const {
+    std::stringstream ss;
+    ss << "{ x=" << std::to_string(x) << ", y=" << std::to_string(y) << " }";
+    return ss.str();
+  }
+};
+
+inline void register_velocity(sol::state &lua) {
+  // clang-format off
+  lua.new_usertype<Velocity>("Velocity",
+    "type_id", &entt::type_hash<Velocity>::value,
+
+    sol::call_constructor,
+    sol::factories([](int x, int y) {
+      return Velocity{ x, y };
+    }),
+    "x", &Velocity::x,
+    "y", &Velocity::y,
+
+    sol::meta_function::to_string, &Velocity::to_string
+  );
+  // clang-format on
+  stamp_type_id<Velocity>(lua["Velocity"]);
+}
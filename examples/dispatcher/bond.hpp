@@ -1,7 +1,11 @@
 #pragma once
 
 #include "entt/signal/dispatcher.hpp"
+#include "event_batch.hpp"
+#include "event_ingress.hpp"
 #include "meta_helper.hpp"
+#include "profiler.hpp"
+#include "script_event.hpp"
 
 template <typename Event>
 auto connect_listener(entt::dispatcher *dispatcher, const sol::function &f) {
@@ -29,6 +33,7 @@ auto connect_listener(entt::dispatcher *dispatcher, const sol::function &f) {
     script_listener &operator=(script_listener &&) noexcept = default;
 
     void receive(const Event &evt) {
+      PROFILER_ZONE("listener", entt::type_name<Event>::value());
       if (connection && callback.valid()) callback(evt);
     }
 
@@ -38,6 +43,13 @@ auto connect_listener(entt::dispatcher *dispatcher, const sol::function &f) {
 
   return std::make_unique<script_listener>(*dispatcher, f);
 }
+// All events of a type in one call per update, @see native_batch_listener
+template <typename Event>
+auto connect_batch_listener(entt::dispatcher *dispatcher,
+                            const sol::function &f) {
+  assert(dispatcher && f.valid());
+  return std::make_unique<native_batch_listener<Event>>(*dispatcher, f);
+}
 template <typename Event>
 void trigger_event(entt::dispatcher *dispatcher, const sol::table &evt) {
   assert(dispatcher && evt.valid());
@@ -57,37 +69,85 @@ template <typename Event> void update_event(entt::dispatcher *dispatcher) {
   dispatcher->update<Event>();
 }
 
+// Value events have pools of script_value_event, others of base_script_event
+// (a pool is cast to its type unchecked), a mismatch raises a lua error
+inline void expect_value_event(const sol::table &type, bool value_event) {
+  if (is_value_event(type) == value_event) return;
+  throw sol::error{value_event
+                     ? "not a value event, use dispatcher:trigger/enqueue"
+                     : "value event, use dispatcher:trigger_values/"
+                       "enqueue_values"};
+}
+
+// Typed entry points of an event, @see dispatch_cache
+struct event_dispatch {
+  static constexpr auto id = entt::hashed_string::value("event_dispatch");
+
+  entt::meta_any (*connect_listener)(entt::dispatcher *,
+                                     const sol::function &);
+  entt::meta_any (*connect_batch_listener)(entt::dispatcher *,
+                                           const sol::function &);
+  void (*trigger)(entt::dispatcher *, const sol::table &);
+  void (*enqueue)(entt::dispatcher *, const sol::table &);
+  void (*clear)(entt::dispatcher *);
+  void (*update)(entt::dispatcher *);
+};
+template <typename Event> const event_dispatch *get_event_dispatch() {
+  static constexpr event_dispatch table{
+    [](entt::dispatcher *dispatcher, const sol::function &f) {
+      return entt::meta_any{connect_listener<Event>(dispatcher, f)};
+    },
+    [](entt::dispatcher *dispatcher, const sol::function &f) {
+      return entt::meta_any{connect_batch_listener<Event>(dispatcher, f)};
+    },
+    &trigger_event<Event>,
+    &enqueue_event<Event>,
+    &clear_event<Event>,
+    &update_event<Event>,
+  };
+  return &table;
+}
+[[nodiscard]] inline const event_dispatch *
+find_event_dispatch(entt::id_type type_id) {
+  return dispatch_cache<event_dispatch>::find(type_id);
+}
+
 template <typename Event> void register_meta_event() {
   using namespace entt::literals;
 
   entt::meta<Event>()
+    .template func<&get_event_dispatch<Event>>(event_dispatch::id)
     .template func<&connect_listener<Event>>("connect_listener"_hs)
+    .template func<&connect_batch_listener<Event>>(
+      "connect_batch_listener"_hs)
     .template func<&trigger_event<Event>>("trigger_event"_hs)
     .template func<&enqueue_event<Event>>("enqueue_event"_hs)
     .template func<&clear_event<Event>>("clear_event"_hs)
     .template func<&update_event<Event>>("update_event"_hs);
+  register_ingress_event<Event>();
+
+  invalidate_dispatch_caches();
 }
 
-[[nodiscard]] sol::table open_dispatcher(sol::this_state s) {
+[[nodiscard]] inline sol::table open_dispatcher(sol::this_state s) {
   // To create a dispatcher in a script: entt.dispatcher.new()
 
   sol::state_view lua{s};
   auto entt_module = lua["entt"].get_or_create<sol::table>();
 
-  struct base_script_event {
-    sol::table self;
-  };
   // clang-format off
   lua.new_usertype<base_script_event>("BaseScriptEvent",
-    "type_id", [] { return entt::type_hash<base_script_event>::value(); }
+    "type_id", [] { return entt::type_hash<base_script_event>::value(); },
+    "define", &define_script_event
   );
   // clang-format on
+  stamp_type_id<base_script_event>(lua["BaseScriptEvent"]);
 
   struct scripted_event_listener {
     scripted_event_listener(entt::dispatcher &dispatcher,
-                            const sol::table &type, const sol::function &f)
-        : key{get_key(type)}, callback{f} {
-      connection = dispatcher.sink<base_script_event>()
+                            entt::id_type event_id, const sol::function &f)
+        : callback{f} {
+      connection = dispatcher.sink<base_script_event>(event_id)
                      .connect<&scripted_event_listener::receive>(*this);
     }
     scripted_event_listener(const scripted_event_listener &) = delete;
@@ -99,17 +159,40 @@ template <typename Event> void register_meta_event() {
     scripted_event_listener &
     operator=(scripted_event_listener &&) noexcept = default;
 
-    static uintptr_t get_key(const sol::table &t) {
-      return reinterpret_cast<uintptr_t>(
-        t["__index"].get<sol::table>().pointer());
+    void receive(const base_script_event &evt) const {
+      PROFILER_ZONE("listener", "script_event");
+      assert(connection && callback.valid());
+      callback(evt.self);
     }
 
-    void receive(const base_script_event &evt) const {
+    const sol::function callback;
+    entt::connection connection;
+  };
+  // Receives values of an event as arguments, @see script_value_event
+  struct scripted_value_listener {
+    scripted_value_listener(entt::dispatcher &dispatcher,
+                            entt::id_type event_id, const sol::function &f)
+        : callback{f} {
+      connection = dispatcher.sink<script_value_event>(event_id)
+                     .connect<&scripted_value_listener::receive>(*this);
+    }
+    scripted_value_listener(const scripted_value_listener &) = delete;
+    scripted_value_listener(scripted_value_listener &&) noexcept = default;
+    ~scripted_value_listener() { connection.release(); }
+
+    scripted_value_listener &
+    operator=(const scripted_value_listener &) = delete;
+    scripted_value_listener &
+    operator=(scripted_value_listener &&) noexcept = default;
+
+    void receive(const script_value_event &evt) const {
+      PROFILER_ZONE("listener", "script_value_event");
       assert(connection && callback.valid());
-      if (auto &[self] = evt; get_key(self) == key) callback(self);
+      lua_State *L = callback.lua_state();
+      callback.push(L);
+      lua_call(L, push_values(L, evt), 0);
     }
 
-    const uintptr_t key;
     const sol::function callback;
     entt::connection connection;
   };
@@ -123,55 +206,136 @@ template <typename Event> void register_meta_event() {
 
     "trigger",
       [](entt::dispatcher &self, const sol::table &evt) {
-        if (const auto event_id = get_type_id(evt);
+        PROFILER_ZONE("dispatcher", "trigger");
+        if (const auto event_id = deduce_type(evt);
             event_id == entt::type_hash<base_script_event>::value()) {
-          self.trigger(base_script_event{evt});
-        } else {
-          invoke_meta_func(event_id, "trigger_event"_hs, &self, evt);
+          expect_value_event(evt, false);
+          const auto script_event_id = get_script_event_id(evt);
+          self.trigger(script_event_id,
+                       make_script_event(evt, script_event_id));
+        } else if (const auto *event = find_event_dispatch(event_id); event) {
+          event->trigger(&self, evt);
         }
       },
     "enqueue",
       [](entt::dispatcher &self, const sol::table &evt) {
-        if (const auto event_id = get_type_id(evt);
+        PROFILER_ZONE("dispatcher", "enqueue");
+        if (const auto event_id = deduce_type(evt);
             event_id == entt::type_hash<base_script_event>::value()) {
-          self.enqueue(base_script_event{evt});
-        } else {
-          invoke_meta_func(event_id, "enqueue_event"_hs, &self, evt);
+          expect_value_event(evt, false);
+          const auto script_event_id = get_script_event_id(evt);
+          self.enqueue_hint(script_event_id,
+                            make_script_event(evt, script_event_id));
+        } else if (const auto *event = find_event_dispatch(event_id); event) {
+          event->enqueue(&self, evt);
         }
       },
+    // Value-typed events, e.g. dispatcher:trigger_values(Damage, target, 10)
+    "trigger_values",
+      [](entt::dispatcher &self, const sol::table &type,
+         const sol::variadic_args &va) {
+        PROFILER_ZONE("dispatcher", "trigger_values");
+        expect_value_event(type, true);
+        self.trigger(get_script_event_id(type), make_value_event(va));
+      },
+    "enqueue_values",
+      [](entt::dispatcher &self, const sol::table &type,
+         const sol::variadic_args &va) {
+        PROFILER_ZONE("dispatcher", "enqueue_values");
+        expect_value_event(type, true);
+        self.enqueue_hint(get_script_event_id(type), make_value_event(va));
+      },
     "clear",
       sol::overload(
-        [](entt::dispatcher &self) { self.clear(); },
+        [](entt::dispatcher &self) {
+          PROFILER_ZONE("dispatcher", "clear");
+          self.clear();
+        },
         [](entt::dispatcher &self, const sol::object &type_or_id) {
-          invoke_meta_func(
-            deduce_type(type_or_id), "clear_event"_hs, &self);
+          PROFILER_ZONE("dispatcher", "clear");
+          if (const auto event_id = deduce_type(type_or_id);
+              event_id == entt::type_hash<base_script_event>::value()) {
+            const sol::table type = type_or_id;
+            if (is_value_event(type)) {
+              self.clear<script_value_event>(get_script_event_id(type));
+            } else {
+              self.clear<base_script_event>(get_script_event_id(type));
+            }
+          } else if (const auto *event = find_event_dispatch(event_id);
+                     event) {
+            event->clear(&self);
+          }
         }
       ),
+    // Batch listeners are flushed after (once per update)
     "update",
       sol::overload(
-        [](entt::dispatcher &self) { self.update(); },
+        [](entt::dispatcher &self) {
+          PROFILER_ZONE("dispatcher", "update");
+          self.update();
+          basic_batch_listener::flush_all(self);
+        },
         [](entt::dispatcher &self, const sol::object &type_or_id) {
-          invoke_meta_func(
-            deduce_type(type_or_id), "update_event"_hs, &self);
+          PROFILER_ZONE("dispatcher", "update");
+          if (const auto event_id = deduce_type(type_or_id);
+              event_id == entt::type_hash<base_script_event>::value()) {
+            const sol::table type = type_or_id;
+            if (is_value_event(type)) {
+              self.update<script_value_event>(get_script_event_id(type));
+            } else {
+              self.update<base_script_event>(get_script_event_id(type));
+            }
+          } else if (const auto *event = find_event_dispatch(event_id);
+                     event) {
+            event->update(&self);
+          }
+          basic_batch_listener::flush_all(self);
         }
       ),
     "connect",
       [](entt::dispatcher &self, const sol::object &type_or_id,
          const sol::function &listener, sol::this_state s) {
+        PROFILER_ZONE("dispatcher", "connect");
         if (!listener.valid()) {
           // TODO: warning message
           return entt::meta_any{};
         }
         if (const auto event_id = deduce_type(type_or_id);
             event_id == entt::type_hash<base_script_event>::value()) {
+          const sol::table type = type_or_id;
+          if (is_value_event(type)) {
+            return entt::meta_any{std::make_unique<scripted_value_listener>(
+              self, get_script_event_id(type), listener)};
+          }
           return entt::meta_any{std::make_unique<scripted_event_listener>(
-            self, type_or_id, listener)};
-        } else {
-          return invoke_meta_func(event_id, "connect_listener"_hs, &self,
-                                  listener);
+            self, get_script_event_id(type), listener)};
+        } else if (const auto *event = find_event_dispatch(event_id); event) {
+          return event->connect_listener(&self, listener);
+        }
+        return entt::meta_any{};
+      },
+    // Listener receives all events of a type (queued or triggered) at once,
+    // during dispatcher:update (not supported by value-typed events)
+    "connect_batch",
+      [](entt::dispatcher &self, const sol::object &type_or_id,
+         const sol::function &listener) {
+        PROFILER_ZONE("dispatcher", "connect_batch");
+        if (!listener.valid()) return entt::meta_any{};
+
+        if (const auto event_id = deduce_type(type_or_id);
+            event_id == entt::type_hash<base_script_event>::value()) {
+          const sol::table type = type_or_id;
+          if (is_value_event(type))
+            throw sol::error{"value events can't be batched"};
+          return entt::meta_any{std::make_unique<script_batch_listener>(
+            self, get_script_event_id(type), listener)};
+        } else if (const auto *event = find_event_dispatch(event_id); event) {
+          return event->connect_batch_listener(&self, listener);
         }
+        return entt::meta_any{};
       },
     "disconnect", [](sol::table connection) {
+      PROFILER_ZONE("dispatcher", "disconnect");
       connection.as<entt::meta_any>().reset();
     }
   );
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include <vector>
+#include "entt/signal/dispatcher.hpp"
+#include "profiler.hpp"
+#include "script_event.hpp"
+
+// Listener of all events of a type delivered between flushes (one call into
+// Lua per dispatcher:update), @see dispatcher:connect_batch
+class basic_batch_listener {
+  struct registration {
+    std::vector<basic_batch_listener *> listeners;
+    bool flushing{false};
+  };
+  // Node based, listeners of other dispatchers might be connected during
+  // flush
+  [[nodiscard]] static auto &get_registrations() {
+    static std::unordered_map<const entt::dispatcher *, registration> map;
+    return map;
+  }
+
+public:
+  explicit basic_batch_listener(const entt::dispatcher &dispatcher)
+      : m_dispatcher{&dispatcher} {
+    get_registrations()[m_dispatcher].listeners.push_back(this);
+  }
+  basic_batch_listener(const basic_batch_listener &) = delete;
+  virtual ~basic_batch_listener() {
+    auto &registrations = get_registrations();
+    auto &r = registrations[m_dispatcher];
+    auto it = std::find(r.listeners.begin(), r.listeners.end(), this);
+    assert(it != r.listeners.end());
+    // Might be disconnected by a listener during flush
+    if (r.flushing) {
+      *it = nullptr;
+    } else {
+      r.listeners.erase(it);
+      if (r.listeners.empty()) registrations.erase(m_dispatcher);
+    }
+  }
+
+  basic_batch_listener &operator=(const basic_batch_listener &) = delete;
+
+  // Called by dispatcher:update, call it after dispatcher.update() in c++
+  static void flush_all(const entt::dispatcher &dispatcher) {
+    auto &registrations = get_registrations();
+    const auto it = registrations.find(&dispatcher);
+    if (it == registrations.end()) return;
+
+    // Stable, unlike the iterator (callbacks might rehash the map)
+    auto &r = it->second;
+    r.flushing = true;
+    // Listeners connected during flush are flushed as well
+    for (std::size_t i = 0; i < r.listeners.size(); ++i) {
+      if (r.listeners[i]) r.listeners[i]->flush();
+    }
+    r.flushing = false;
+    r.listeners.erase(
+      std::remove(r.listeners.begin(), r.listeners.end(), nullptr),
+      r.listeners.end());
+    if (r.listeners.empty()) registrations.erase(&dispatcher);
+  }
+
+protected:
+  virtual void flush() = 0;
+
+private:
+  const entt::dispatcher *m_dispatcher;
+};
+
+// Native events are copied, the listener receives a container userdata
+// (# and [i]) of the events, valid only during the call
+template <typename Event>
+class native_batch_listener final : public basic_batch_listener {
+public:
+  native_batch_listener(entt::dispatcher &dispatcher, const sol::function &f)
+      : basic_batch_listener{dispatcher}, m_callback{f} {
+    m_connection = dispatcher.sink<Event>()
+                     .template connect<&native_batch_listener::receive>(*this);
+  }
+  ~native_batch_listener() override {
+    m_connection.release();
+    m_callback.abandon();
+  }
+
+  void receive(const Event &evt) { m_events.push_back(evt); }
+
+private:
+  void flush() override {
+    if (m_events.empty()) return;
+    PROFILER_ZONE("batch_listener", entt::type_name<Event>::value());
+    m_callback(&m_events);
+    m_events.clear();
+  }
+
+private:
+  sol::function m_callback;
+  entt::connection m_connection;
+  std::vector<Event> m_events;
+};
+
+// Events defined in Lua, the listener receives an array of event tables
+// (reused between flushes). Pooled events are recycled after the flush.
+class script_batch_listener final : public basic_batch_listener {
+public:
+  script_batch_listener(entt::dispatcher &dispatcher, entt::id_type event_id,
+                        const sol::function &f)
+      : basic_batch_listener{dispatcher}, m_callback{f},
+        m_batch{sol::state_view{f.lua_state()}.create_table()} {
+    m_connection = dispatcher.sink<base_script_event>(event_id)
+                     .connect<&script_batch_listener::receive>(*this);
+  }
+  ~script_batch_listener() override {
+    m_connection.release();
+    _release_events();
+  }
+
+  void receive(const base_script_event &evt) {
+    // Same for every event in a batch (one class)
+    m_pooled = evt.pooled;
+    if (m_pooled) retain_script_event(evt.self);
+    m_batch.raw_set(++m_size, evt.self);
+  }
+
+private:
+  void flush() override {
+    if (m_size == 0) return;
+    PROFILER_ZONE("batch_listener", "script_event");
+    m_callback(m_batch);
+    _release_events();
+  }
+
+  void _release_events() {
+    for (std::size_t i = 1; i <= m_size; ++i) {
+      if (m_pooled) release_script_event(m_batch.raw_get<sol::table>(i));
+      m_batch.raw_set(i, sol::lua_nil);
+    }
+    m_size = 0;
+  }
+
+private:
+  sol::function m_callback;
+  sol::table m_batch;
+  std::size_t m_size{0};
+  bool m_pooled{false};
+  entt::connection m_connection;
+};
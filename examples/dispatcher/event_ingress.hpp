@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "entt/signal/dispatcher.hpp"
+#include "profiler.hpp"
+
+// Multi-producer single-consumer queue of a native event.
+// Producers push nodes onto a lock-free stack (never block), the consumer
+// takes the whole stack with a single exchange, so there is no ABA problem.
+class basic_ingress_queue {
+public:
+  virtual ~basic_ingress_queue() = default;
+
+  // Moves (enqueues) pending events into a dispatcher, in order of push
+  virtual std::size_t drain(entt::dispatcher &) = 0;
+};
+
+template <typename Event>
+class ingress_queue final : public basic_ingress_queue {
+  struct node {
+    Event event;
+    node *next;
+  };
+
+public:
+  ingress_queue() = default;
+  ingress_queue(const ingress_queue &) = delete;
+  ~ingress_queue() override {
+    auto *head = m_head.exchange(nullptr, std::memory_order_acquire);
+    while (head)
+      delete std::exchange(head, head->next);
+  }
+
+  ingress_queue &operator=(const ingress_queue &) = delete;
+
+  // Any thread
+  void push(Event &&evt) {
+    auto *n = new node{std::move(evt), m_head.load(std::memory_order_relaxed)};
+    while (!m_head.compare_exchange_weak(n->next, n, std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+    }
+  }
+
+  // Consumer thread only
+  std::size_t drain(entt::dispatcher &dispatcher) override {
+    auto *head = m_head.exchange(nullptr, std::memory_order_acquire);
+    // Stack (LIFO) to the order of push
+    node *first{nullptr};
+    while (head) {
+      auto *next = head->next;
+      head->next = first;
+      first = std::exchange(head, next);
+    }
+
+    std::size_t count{0};
+    while (first) {
+      dispatcher.enqueue(std::move(first->event));
+      delete std::exchange(first, first->next);
+      ++count;
+    }
+    return count;
+  }
+
+private:
+  std::atomic<node *> m_head{nullptr};
+};
+
+namespace detail {
+
+using ingress_factory = std::unique_ptr<basic_ingress_queue> (*)();
+
+inline std::vector<ingress_factory> &get_ingress_factories() {
+  static std::vector<ingress_factory> factories;
+  return factories;
+}
+template <typename Event> struct ingress_slot {
+  static inline auto index = std::numeric_limits<std::size_t>::max();
+};
+
+} // namespace detail
+
+// Called by register_meta_event (main thread, before any event_ingress
+// is created)
+template <typename Event> void register_ingress_event() {
+  auto &index = detail::ingress_slot<Event>::index;
+  if (index != std::numeric_limits<std::size_t>::max()) return;
+
+  auto &factories = detail::get_ingress_factories();
+  index = factories.size();
+  factories.push_back([]() -> std::unique_ptr<basic_ingress_queue> {
+    return std::make_unique<ingress_queue<Event>>();
+  });
+}
+
+// Native events sent from other threads (network, I/O) into a dispatcher.
+// A queue per event type registered with register_meta_event, events are
+// delivered to the dispatcher queue by drain() (on the Lua thread), so the
+// next dispatcher:update() passes them to listeners.
+class event_ingress {
+public:
+  explicit event_ingress(entt::dispatcher &dispatcher)
+      : m_dispatcher{dispatcher} {
+    const auto &factories = detail::get_ingress_factories();
+    m_queues.reserve(factories.size());
+    for (const auto factory : factories)
+      m_queues.push_back(factory());
+  }
+  event_ingress(const event_ingress &) = delete;
+
+  event_ingress &operator=(const event_ingress &) = delete;
+
+  // Any thread
+  template <typename Event> void push(Event evt) {
+    const auto index = detail::ingress_slot<Event>::index;
+    assert(index < m_queues.size() && "Unregistered event type");
+    static_cast<ingress_queue<Event> &>(*m_queues[index]).push(std::move(evt));
+  }
+
+  // Consumer (Lua) thread, before dispatcher.update()
+  std::size_t drain() {
+    PROFILER_ZONE("dispatcher", "drain_ingress");
+    std::size_t count{0};
+    for (auto &queue : m_queues)
+      count += queue->drain(m_dispatcher);
+    return count;
+  }
+
+private:
+  entt::dispatcher &m_dispatcher;
+  std::vector<std::unique_ptr<basic_ingress_queue>> m_queues;
+};
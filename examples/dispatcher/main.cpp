@@ -1,5 +1,8 @@
+#include <atomic>
+#include <thread>
 #include "bond.hpp"
 #include "../common/kbhit.hpp"
+#include "gc_controller.hpp"
 
 #define AUTO_ARG(x) decltype(x), x
 
@@ -20,6 +23,29 @@ struct native_listener {
   }
 };
 
+// Simulates a network thread, sends TestEvent every second
+class network_thread {
+public:
+  explicit network_thread(event_ingress &ingress)
+      : m_thread{[this, &ingress] {
+          for (int i = 0; m_running; ++i) {
+            ingress.push(TestEvent{"network", i});
+            std::this_thread::sleep_for(std::chrono::seconds{1});
+          }
+        }} {}
+  network_thread(const network_thread &) = delete;
+  ~network_thread() {
+    m_running = false;
+    m_thread.join();
+  }
+
+  network_thread &operator=(const network_thread &) = delete;
+
+private:
+  std::atomic<bool> m_running{true};
+  std::thread m_thread;
+};
+
 void expose_test_event(sol::state &lua) {
   // clang-format off
   lua.new_usertype<TestEvent>("TestEvent",
@@ -36,6 +62,7 @@ void expose_test_event(sol::state &lua) {
     sol::meta_function::to_string, &TestEvent::to_string
   );
   // clang-format on
+  stamp_type_id<TestEvent>(lua["TestEvent"]);
 }
 
 } // namespace
@@ -58,6 +85,7 @@ int main(int argc, char *argv[]) {
     lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::string);
 
     lua.require("dispatcher", sol::c_call<AUTO_ARG(&open_dispatcher)>, false);
+    lua.require("profiler", sol::c_call<AUTO_ARG(&open_profiler)>, false);
     expose_test_event(lua); // Make TestEvent available to Lua
 
     lua["dispatcher"] =
@@ -79,10 +107,23 @@ int main(int argc, char *argv[]) {
       "dispatcher:enqueue(Foo({ message = 'press any key to exit' }))");
     dispatcher.enqueue(TestEvent{"c++", 10});
 
+    using namespace std::chrono_literals;
+
+    // Steps the collector within time left in a frame
+    gc_controller gc{lua};
+    constexpr auto frame_budget = 16ms;
+
+    // Events pushed from other threads, delivered by drain()
+    event_ingress ingress{dispatcher};
+    network_thread network{ingress};
+
     while (true) {
-      lua.step_gc(4);
+      const auto begin_ticks = gc_controller::clock::now();
 
+      ingress.drain();
       lua.script("dispatcher:update()");
+      gc.step_until(begin_ticks + frame_budget);
+      profiler::get().frame();
 
       if (_kbhit()) break;
     }
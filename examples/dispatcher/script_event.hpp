@@ -0,0 +1,279 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <limits>
+#include <string>
+#include <variant>
+#include "entt/container/dense_set.hpp"
+#include "meta_helper.hpp"
+
+// Raw fields of an event class (defined in Lua, derived from BaseScriptEvent)
+inline constexpr const char *event_id_key = "__event_id";
+inline constexpr const char *event_pool_key = "__pool";
+inline constexpr const char *value_event_key = "__value_event";
+// Raw field of an instance that is already in the pool
+inline constexpr const char *in_pool_key = "__in_pool";
+// Raw field of an instance held by batch listeners (count)
+inline constexpr const char *in_batch_key = "__in_batch";
+
+// Returns a table to the pool of its class (if the class is pooled).
+// Fields are cleared, so the table can't be used by listeners afterwards,
+// nor by the sender (a pooled event must not be reused once triggered or
+// enqueued, construct a new one).
+inline void recycle_script_event(const sol::table &evt) {
+  lua_State *L = evt.lua_state();
+  evt.push();
+  // Recycled by release_script_event
+  lua_pushstring(L, in_batch_key);
+  lua_rawget(L, -2);
+  const auto in_batch = !lua_isnil(L, -1);
+  lua_pop(L, 1);
+  if (in_batch || !lua_getmetatable(L, -1)) {
+    lua_pop(L, 1);
+    return;
+  }
+  lua_pushstring(L, event_pool_key);
+  lua_rawget(L, -2);
+  lua_pushstring(L, in_pool_key);
+  lua_rawget(L, -4);
+  // evt, class, pool, in_pool
+  if (lua_type(L, -2) == LUA_TTABLE && lua_isnil(L, -1)) {
+    lua_pop(L, 1);
+
+    lua_pushnil(L);
+    while (lua_next(L, -4)) {
+      lua_pop(L, 1);
+      lua_pushvalue(L, -1);
+      lua_pushnil(L);
+      lua_rawset(L, -6);
+    }
+    lua_pushstring(L, in_pool_key);
+    lua_pushboolean(L, true);
+    lua_rawset(L, -5);
+
+    const auto size = static_cast<lua_Integer>(lua_rawlen(L, -1));
+    lua_pushvalue(L, -3);
+    lua_rawseti(L, -2, size + 1);
+    lua_pop(L, 3);
+  } else {
+    lua_pop(L, 4);
+  }
+}
+
+// Number of batches holding an event (see event_batch.hpp)
+[[nodiscard]] inline lua_Integer get_batch_count(lua_State *L, int index) {
+  lua_pushstring(L, in_batch_key);
+  lua_rawget(L, index < 0 ? index - 1 : index);
+  const auto count = lua_tointeger(L, -1);
+  lua_pop(L, 1);
+  return count;
+}
+// Delays recycling of an event until it's released (by every batch)
+inline void retain_script_event(const sol::table &evt) {
+  lua_State *L = evt.lua_state();
+  evt.push();
+  const auto count = get_batch_count(L, -1);
+  lua_pushstring(L, in_batch_key);
+  lua_pushinteger(L, count + 1);
+  lua_rawset(L, -3);
+  lua_pop(L, 1);
+}
+inline void release_script_event(const sol::table &evt) {
+  lua_State *L = evt.lua_state();
+  evt.push();
+  const auto count = get_batch_count(L, -1);
+  lua_pushstring(L, in_batch_key);
+  if (count > 1) {
+    lua_pushinteger(L, count - 1);
+  } else {
+    lua_pushnil(L);
+  }
+  lua_rawset(L, -3);
+  lua_pop(L, 1);
+  if (count <= 1) recycle_script_event(evt);
+}
+
+// Ids of pooled event classes, one set per lua state (filled by
+// define_script_event), so other events skip recycle_script_event
+class pooled_script_events {
+public:
+  [[nodiscard]] static pooled_script_events &get(lua_State *L) {
+    static const char key{};
+    lua_rawgetp(L, LUA_REGISTRYINDEX, &key);
+    if (lua_type(L, -1) != LUA_TUSERDATA) {
+      lua_pop(L, 1);
+      sol::stack::push(L, pooled_script_events{});
+      lua_pushvalue(L, -1);
+      lua_rawsetp(L, LUA_REGISTRYINDEX, &key);
+    }
+    auto &self = sol::stack::get<pooled_script_events &>(L, -1);
+    lua_pop(L, 1);
+    return self;
+  }
+
+  void add(entt::id_type event_id) { m_ids.insert(event_id); }
+  [[nodiscard]] bool contains(entt::id_type event_id) const {
+    return m_ids.contains(event_id);
+  }
+
+private:
+  entt::dense_set<entt::id_type> m_ids;
+};
+
+struct base_script_event {
+  base_script_event(sol::table t, bool is_pooled)
+      : self{std::move(t)}, pooled{is_pooled} {}
+  base_script_event(const base_script_event &) = delete;
+  base_script_event(base_script_event &&) noexcept = default;
+  ~base_script_event() {
+    if (pooled && self.valid()) recycle_script_event(self);
+  }
+
+  base_script_event &operator=(const base_script_event &) = delete;
+  base_script_event &operator=(base_script_event &&other) noexcept {
+    if (this != &other) {
+      if (pooled && self.valid()) recycle_script_event(self);
+      self = std::move(other.self);
+      pooled = other.pooled;
+    }
+    return *this;
+  }
+
+  sol::table self;
+  bool pooled;
+};
+
+// Event without a Lua table, its values are passed to listeners as
+// arguments. Only nil, numbers, booleans and strings are supported (up to
+// max_values), anything else raises a lua error.
+struct script_value_event {
+  static constexpr std::size_t max_values = 6;
+  using value_type = std::variant<std::monostate, bool, lua_Integer,
+                                  lua_Number, std::string>;
+
+  std::array<value_type, max_values> values;
+  std::size_t size{0};
+};
+
+[[nodiscard]] inline script_value_event
+make_value_event(const sol::variadic_args &va) {
+  if (va.size() > script_value_event::max_values) {
+    throw sol::error{"too many event values: " + std::to_string(va.size()) +
+                     " (max " +
+                     std::to_string(script_value_event::max_values) + ")"};
+  }
+
+  script_value_event evt{};
+  lua_State *L = va.lua_state();
+  for (auto i = va.stack_index(); i <= va.top(); ++i) {
+    auto &value = evt.values[evt.size++];
+    switch (lua_type(L, i)) {
+    case LUA_TBOOLEAN:
+      value = lua_toboolean(L, i) != 0;
+      break;
+    case LUA_TNUMBER:
+#if LUA_VERSION_NUM >= 503
+      if (lua_isinteger(L, i)) {
+        value = lua_tointeger(L, i);
+        break;
+      }
+#endif
+      value = lua_tonumber(L, i);
+      break;
+    case LUA_TSTRING: {
+      std::size_t length{0};
+      const auto *str = lua_tolstring(L, i, &length);
+      value = std::string{str, length};
+    } break;
+    case LUA_TNIL:
+      break;
+    default:
+      throw sol::error{std::string{"unsupported type of event value: "} +
+                       luaL_typename(L, i)};
+    }
+  }
+  return evt;
+}
+inline int push_values(lua_State *L, const script_value_event &evt) {
+  for (std::size_t i = 0; i < evt.size; ++i) {
+    std::visit(
+      [L](const auto &value) {
+        using T = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<T, bool>) {
+          lua_pushboolean(L, value);
+        } else if constexpr (std::is_same_v<T, lua_Integer>) {
+          lua_pushinteger(L, value);
+        } else if constexpr (std::is_same_v<T, lua_Number>) {
+          lua_pushnumber(L, value);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+          lua_pushlstring(L, value.data(), value.size());
+        } else {
+          lua_pushnil(L);
+        }
+      },
+      evt.values[i]);
+  }
+  return static_cast<int>(evt.size);
+}
+
+// Every event type defined in Lua gets an id, used as a name of its own pool
+// in a dispatcher (so only listeners of that type are notified).
+// Ids are tagged (high bit) and skip ids of registered meta types, so a
+// script pool doesn't take the pool of a native event (type_hash).
+inline constexpr entt::id_type script_event_id_tag{
+  entt::id_type{1} << (std::numeric_limits<entt::id_type>::digits - 1)};
+[[nodiscard]] inline entt::id_type next_script_event_id() {
+  static std::atomic<entt::id_type> next{1};
+  while (true) {
+    const auto id = next++ | script_event_id_tag;
+    if (id != entt::type_hash<base_script_event>::value() &&
+        !entt::resolve(id)) {
+      return id;
+    }
+  }
+}
+// Assigns an id to a class derived from BaseScriptEvent (once).
+// Options:
+//  pooled = true  instances are recycled after delivery
+//  values = true  value-typed event (trigger_values/enqueue_values)
+inline entt::id_type
+define_script_event(sol::table type,
+                    const sol::optional<sol::table> &options = sol::nullopt) {
+  auto id = type.raw_get<sol::optional<entt::id_type>>(event_id_key);
+  if (!id) {
+    id = next_script_event_id();
+    type.raw_set(event_id_key, *id, type_id_key,
+                 entt::type_hash<base_script_event>::value());
+  }
+  if (options) {
+    if (options->get_or("pooled", false) &&
+        !type.raw_get<sol::optional<sol::table>>(event_pool_key)) {
+      type.raw_set(event_pool_key,
+                   sol::state_view{type.lua_state()}.create_table());
+      pooled_script_events::get(type.lua_state()).add(*id);
+    }
+    if (options->get_or("values", false)) type.raw_set(value_event_key, 1);
+  }
+  return *id;
+}
+// Works with both, class and its instance
+[[nodiscard]] inline entt::id_type get_script_event_id(const sol::table &obj) {
+  if (entt::id_type id; get_stamped_id(obj, event_id_key, id)) return id;
+  // Class not defined with define_event (BaseScriptEvent.define)
+  if (const sol::object type = obj["__index"]; type.is<sol::table>())
+    return define_script_event(type);
+  // BaseScriptEvent itself, default pool
+  return entt::type_hash<base_script_event>::value();
+}
+// Wraps an instance for a dispatcher, event_id of its class
+[[nodiscard]] inline base_script_event
+make_script_event(const sol::table &evt, entt::id_type event_id) {
+  return base_script_event{
+    evt, pooled_script_events::get(evt.lua_state()).contains(event_id)};
+}
+// Works with both, class and its instance
+[[nodiscard]] inline bool is_value_event(const sol::table &obj) {
+  entt::id_type unused;
+  return get_stamped_id(obj, value_event_key, unused);
+}
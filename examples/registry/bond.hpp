@@ -3,7 +3,144 @@
 #include "entt/entity/registry.hpp"
 #include "entt/entity/runtime_view.hpp"
 #include "meta_helper.hpp"
-#include <set>
+#include "profiler.hpp"
+#include "column.hpp"
+#include "deferred_patch.hpp"
+#include "group.hpp"
+#include "observer.hpp"
+#include "query.hpp"
+#include "snapshot.hpp"
+#include <algorithm>
+#include <array>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Tables of a proxy cache (per type and lua state, in the lua registry):
+// proxies, and the owner (storage, entity) of every cached address.
+// Owners are plain values, so a cache miss allocates only the proxy.
+template <typename Component> struct proxy_cache {
+  static inline const char proxies{};
+  static inline const char storages{};
+  static inline const char entities{};
+};
+// Returns true if the table has been created
+inline bool push_cache_table(lua_State *L, const void *key) {
+  lua_rawgetp(L, LUA_REGISTRYINDEX, key);
+  if (lua_type(L, -1) == LUA_TTABLE) return false;
+  lua_pop(L, 1);
+  lua_newtable(L);
+  lua_pushvalue(L, -1);
+  lua_rawsetp(L, LUA_REGISTRYINDEX, key);
+  return true;
+}
+
+// __newindex of proxies (Component *), calls the original one (upvalue) and
+// then patches the component (emits on_update, @see registry:observe and
+// request_patch).
+template <typename Component> int patch_on_new_index(lua_State *L) {
+  const auto top = lua_gettop(L);
+  lua_pushvalue(L, lua_upvalueindex(1));
+  for (int i = 1; i <= top; ++i)
+    lua_pushvalue(L, i);
+  lua_call(L, top, 0);
+
+  auto *comp = sol::stack::get<Component *>(L, 1);
+  lua_rawgetp(L, LUA_REGISTRYINDEX, &proxy_cache<Component>::storages);
+  lua_rawgetp(L, LUA_REGISTRYINDEX, &proxy_cache<Component>::entities);
+  if (lua_type(L, -2) == LUA_TTABLE && lua_type(L, -1) == LUA_TTABLE) {
+    lua_rawgetp(L, -2, comp);
+    lua_rawgetp(L, -2, comp);
+    auto *storage =
+      static_cast<entt::storage_for_t<Component> *>(lua_touserdata(L, -2));
+    const auto entity = static_cast<entt::entity>(lua_tointeger(L, -1));
+    // Stale proxy (component moved) is not patched
+    if (storage && storage->contains(entity) &&
+        &storage->get(entity) == comp) {
+      request_patch(*storage, entity, &component_patch<Component>);
+    }
+  }
+  return 0;
+}
+// Once per lua state, @see push_component_proxy
+template <typename Component> void track_proxy_writes(lua_State *L) {
+  luaL_getmetatable(L, sol::usertype_traits<Component *>::metatable().c_str());
+  if (lua_type(L, -1) == LUA_TTABLE) {
+    lua_pushliteral(L, "__newindex");
+    lua_rawget(L, -2);
+    lua_pushliteral(L, "__newindex");
+    lua_insert(L, -2);
+    lua_pushcclosure(L, &patch_on_new_index<Component>, 1);
+    lua_rawset(L, -3);
+  }
+  lua_pop(L, 1);
+}
+
+// Pushes a proxy (userdata with a pointer) of a component.
+// Proxies are cached per lua state (@see proxy_cache) and keyed by address,
+// so getting the same component again doesn't allocate (nor does it produce
+// garbage). The cache holds at most one proxy per address a component of the
+// type ever had (storages keep their pages), the owner of an address is
+// rebound on every push. A proxy is valid as long as its component stays in
+// place, with pointer stability (in_place_delete) it's bound to its entity
+// until the component is removed.
+// Writes through a proxy patch the component (emit on_update).
+template <typename Component>
+int push_component_proxy(lua_State *L,
+                         entt::storage_for_t<Component> &storage,
+                         entt::entity entity, Component &comp) {
+  using cache = proxy_cache<Component>;
+  if (push_cache_table(L, &cache::proxies)) {
+    sol::stack::push(L, &comp); // Creates the metatable (if necessary)
+    lua_pop(L, 1);
+    track_proxy_writes<Component>(L);
+  }
+  lua_rawgetp(L, -1, &comp);
+  if (lua_isnil(L, -1)) {
+    lua_pop(L, 1);
+    sol::stack::push(L, &comp);
+    lua_pushvalue(L, -1);
+    lua_rawsetp(L, -3, &comp);
+  }
+  lua_remove(L, -2);
+
+  // Owner of the address might have changed (component moved)
+  push_cache_table(L, &cache::storages);
+  lua_pushlightuserdata(L, &storage);
+  lua_rawsetp(L, -2, &comp);
+  lua_pop(L, 1);
+  push_cache_table(L, &cache::entities);
+  lua_pushinteger(L, static_cast<lua_Integer>(entt::to_integral(entity)));
+  lua_rawsetp(L, -2, &comp);
+  lua_pop(L, 1);
+  return 1;
+}
+template <typename Component>
+int push_component_proxy(lua_State *L,
+                         entt::storage_for_t<Component> &storage,
+                         entt::entity entity) {
+  return push_component_proxy(L, storage, entity, storage.get(entity));
+}
+template <typename Component>
+sol::reference make_component_proxy(lua_State *L,
+                                    entt::storage_for_t<Component> &storage,
+                                    entt::entity entity) {
+  push_component_proxy<Component>(L, storage, entity);
+  sol::reference proxy{L, -1};
+  lua_pop(L, 1);
+  return proxy;
+}
+
+// Structural changes (and whole-registry writes) are not allowed on script
+// workers, they have to be deferred (@see script_workers)
+inline void expect_registry_owner(const char *binding) {
+  if (on_worker_thread()) {
+    throw sol::error{std::string{"registry:"} + binding +
+                     " can't be called by a worker, use defer"};
+  }
+}
 
 template <typename Component>
 auto is_valid(const entt::registry *registry, entt::entity entity) {
@@ -14,18 +151,26 @@ template <typename Component>
 auto emplace_component(entt::registry *registry, entt::entity entity,
                        const sol::table &instance, sol::this_state s) {
   assert(registry);
-  auto &comp = registry->emplace_or_replace<Component>(
+  registry->emplace_or_replace<Component>(
     entity,
     instance.valid() ? std::move(instance.as<Component &&>()) : Component{});
 
-  return sol::make_reference(s, std::ref(comp));
+  return make_component_proxy(s, registry->storage<Component>(), entity);
 }
+// Emplaces a missing component, except on workers (nil, read-only lookup)
 template <typename Component>
-auto get_component(entt::registry *registry, entt::entity entity,
-                   sol::this_state s) {
+sol::reference get_component(entt::registry *registry, entt::entity entity,
+                             sol::this_state s) {
   assert(registry);
-  auto &comp = registry->get_or_emplace<Component>(entity);
-  return sol::make_reference(s, std::ref(comp));
+  if (on_worker_thread()) {
+    auto *storage = std::as_const(*registry).storage<Component>();
+    if (!storage || !storage->contains(entity))
+      return sol::make_reference(s, sol::lua_nil);
+    return make_component_proxy(
+      s, const_cast<entt::storage_for_t<Component> &>(*storage), entity);
+  }
+  registry->get_or_emplace<Component>(entity);
+  return make_component_proxy(s, registry->storage<Component>(), entity);
 }
 template <typename Component>
 bool has_component(entt::registry *registry, entt::entity entity) {
@@ -41,27 +186,370 @@ template <typename Component> void clear_component(entt::registry *registry) {
   assert(registry);
   registry->clear<Component>();
 }
+template <typename Component>
+void emplace_components(entt::registry *registry,
+                        const std::vector<entt::entity> &entities,
+                        const sol::object &instances) {
+  assert(registry);
+  auto &storage = registry->storage<Component>();
+  const auto owned = [&storage](auto entity) {
+    return storage.contains(entity);
+  };
+  const auto any_owned =
+    std::any_of(entities.cbegin(), entities.cend(), owned);
+
+  // Either an array of instances (one per entity) or a single one (copied
+  // to each entity, nil = default), anything else raises a lua error
+  if (instances.get_type() == sol::type::table) {
+    const auto array = instances.as<sol::table>();
+    std::vector<Component> values;
+    values.reserve(entities.size());
+    for (std::size_t i = 0; i < entities.size(); ++i) {
+      const sol::object value = array.raw_get<sol::object>(i + 1);
+      if (!value.is<Component>()) {
+        throw sol::error{"emplace_many: instance " + std::to_string(i + 1) +
+                         " is not a " +
+                         std::string{entt::type_name<Component>::value()}};
+      }
+      values.push_back(value.as<Component>());
+    }
+    if (!any_owned) {
+      registry->insert<Component>(entities.cbegin(), entities.cend(),
+                                  values.cbegin());
+    } else {
+      for (std::size_t i = 0; i < entities.size(); ++i)
+        registry->emplace_or_replace<Component>(entities[i], values[i]);
+    }
+  } else {
+    if (instances.valid() && instances.get_type() != sol::type::lua_nil &&
+        !instances.is<Component>()) {
+      throw sol::error{"emplace_many: instance is not a " +
+                       std::string{entt::type_name<Component>::value()}};
+    }
+    const auto value = instances.is<Component>() ? instances.as<Component>()
+                                                 : Component{};
+    if (!any_owned) {
+      registry->insert<Component>(entities.cbegin(), entities.cend(), value);
+    } else {
+      for (auto entity : entities)
+        registry->emplace_or_replace<Component>(entity, value);
+    }
+  }
+}
+template <typename Component>
+auto remove_components(entt::registry *registry,
+                       const std::vector<entt::entity> &entities) {
+  assert(registry);
+  return registry->remove<Component>(entities.cbegin(), entities.cend());
+}
+// Pushes (proxy of) a component of an entity in a (typed) storage
+template <typename Component>
+int push_component(lua_State *L, entt::sparse_set *storage,
+                   entt::entity entity) {
+  return push_component_proxy<Component>(
+    L, static_cast<entt::storage_for_t<Component> &>(*storage), entity);
+}
+
+// Typed entry points of a component, @see dispatch_cache
+struct component_dispatch {
+  static constexpr auto id = entt::hashed_string::value("component_dispatch");
+
+  bool (*valid)(const entt::registry *, entt::entity);
+  sol::reference (*emplace)(entt::registry *, entt::entity, const sol::table &,
+                            sol::this_state);
+  sol::reference (*get)(entt::registry *, entt::entity, sol::this_state);
+  bool (*has)(entt::registry *, entt::entity);
+  std::size_t (*remove)(entt::registry *, entt::entity);
+  void (*clear)(entt::registry *);
+  int (*push)(lua_State *, entt::sparse_set *, entt::entity);
+  void (*emplace_many)(entt::registry *, const std::vector<entt::entity> &,
+                       const sol::object &);
+  std::size_t (*remove_many)(entt::registry *,
+                             const std::vector<entt::entity> &);
+  std::optional<component_column> (*column)(entt::registry *, entt::id_type);
+  entt::connection (*observe)(entt::registry *, observer_event,
+                              runtime_observer *);
+};
+template <typename Component>
+const component_dispatch *get_component_dispatch() {
+  static constexpr component_dispatch table{
+    &is_valid<Component>,
+    &emplace_component<Component>,
+    &get_component<Component>,
+    &has_component<Component>,
+    &remove_component<Component>,
+    &clear_component<Component>,
+    &push_component<Component>,
+    &emplace_components<Component>,
+    &remove_components<Component>,
+    &make_column<Component>,
+    &observe_component<Component>,
+  };
+  return &table;
+}
+[[nodiscard]] inline const component_dispatch *
+find_component_dispatch(entt::id_type type_id) {
+  return dispatch_cache<component_dispatch>::find(type_id);
+}
 
 template <typename Component> void register_meta_component() {
   using namespace entt::literals;
 
   entt::meta<Component>()
+    .template func<&get_component_dispatch<Component>>(component_dispatch::id)
     .template func<&is_valid<Component>>("valid"_hs)
     .template func<&emplace_component<Component>>("emplace"_hs)
     .template func<&get_component<Component>>("get"_hs)
     .template func<&has_component<Component>>("has"_hs)
     .template func<&clear_component<Component>>("clear"_hs)
     .template func<&remove_component<Component>>("remove"_hs);
+  if constexpr (std::is_trivially_copyable_v<Component>)
+    register_meta_snapshot<Component>();
+
+  invalidate_dispatch_caches();
+}
+// Reflects a data member (by reference), required by registry:column
+template <typename Component, auto Member>
+void register_meta_data(const char *name) {
+  entt::meta<Component>().template data<Member, entt::as_ref_t>(
+    entt::hashed_string::value(name));
 }
 
-auto collect_types(const sol::variadic_args &va) {
-  std::set<entt::id_type> types;
-  std::transform(va.cbegin(), va.cend(), std::inserter(types, types.begin()),
+// Registered kernels, by name and component types (in order)
+struct kernel_info {
+  std::string name;
+  std::vector<entt::id_type> types;
+  entt::id_type id; // Hashed name
+  void (*invoke)(entt::registry &, const sol::variadic_args &);
+};
+[[nodiscard]] inline std::vector<kernel_info> &get_kernels() {
+  static std::vector<kernel_info> kernels;
+  return kernels;
+}
+[[nodiscard]] inline const kernel_info *
+find_kernel(entt::id_type id, const std::vector<entt::id_type> &types) {
+  const auto &kernels = get_kernels();
+  const auto it =
+    std::find_if(kernels.cbegin(), kernels.cend(), [&](const auto &info) {
+      return info.id == id && info.types == types;
+    });
+  return it != kernels.cend() ? &*it : nullptr;
+}
+
+template <auto Kernel, typename... Components>
+void invoke_kernel(entt::registry &registry, const sol::variadic_args &args) {
+  Kernel(registry.view<Components...>(), args);
+}
+// Native loop over a view, @see registry:apply
+// Called through a typed function pointer (no meta_any boxing of arguments).
+// Kernel signature:
+//  void(entt::view<entt::get_t<Components...>>, const sol::variadic_args &)
+template <auto Kernel, typename... Components>
+void register_meta_kernel(const char *name) {
+  static_assert(sizeof...(Components) > 0);
+  get_kernels().push_back({name,
+                           {entt::type_hash<Components>::value()...},
+                           entt::hashed_string::value(name),
+                           &invoke_kernel<Kernel, Components...>});
+}
+
+template <typename, typename> struct meta_group;
+template <typename... Owned, typename... Get>
+struct meta_group<entt::owned_t<Owned...>, entt::get_t<Get...>> {
+  static auto get(entt::registry &registry) {
+    return registry.group<Owned...>(entt::get<Get...>);
+  }
+
+  static void create(entt::registry &registry) {
+    static_cast<void>(get(registry));
+  }
+  static std::size_t size(entt::registry &registry) {
+    return get(registry).size();
+  }
+
+  // Owned components are packed (same order in all owned storages), so
+  // they are visited without lookups
+  static void each(entt::registry &registry, const sol::function &callback) {
+    PROFILER_ZONE("group", "each");
+    auto group = get(registry);
+    const auto storages = std::forward_as_tuple(registry.storage<Owned>()...,
+                                                registry.storage<Get>()...);
+    lua_State *L = callback.lua_state();
+    constexpr auto num_args =
+      static_cast<int>(1 + sizeof...(Owned) + sizeof...(Get));
+    for (auto element : group.each()) {
+      std::apply(
+        [&](entt::entity entity, auto &...components) {
+          callback.push(L);
+          sol::stack::push(L, entity);
+          (push_component_proxy(
+             L,
+             std::get<entt::storage_for_t<
+               std::remove_reference_t<decltype(components)>> &>(storages),
+             entity, components),
+           ...);
+          lua_call(L, num_args, 0);
+        },
+        element);
+    }
+  }
+  static void each_entity(entt::registry &registry,
+                          const sol::function &callback) {
+    PROFILER_ZONE("group", "each_entity");
+    for (auto entity : get(registry))
+      callback(entity);
+  }
+};
+
+// Owning group (owned types are kept packed in their storages), by name
+// in lua: registry:group("movement")
+// An owned type can't be owned by another group, nor have pointer stability.
+//  register_meta_group<Velocity>("movement", entt::get<Transform>);
+template <typename... Owned, typename... Get>
+void register_meta_group(const char *name, entt::get_t<Get...> = {}) {
+  static_assert(sizeof...(Owned) > 0 && sizeof...(Owned) + sizeof...(Get) > 1,
+                "Single type groups are not supported");
+  static_assert(!(entt::component_traits<Owned>::in_place_delete || ...),
+                "Owned types can't have pointer stability (in_place_delete)");
+  static_assert(!((std::is_empty_v<Owned> || ...) ||
+                  (std::is_empty_v<Get> || ...)),
+                "Empty types (tags) have no proxies");
+
+  using group = meta_group<entt::owned_t<Owned...>, entt::get_t<Get...>>;
+  group_info info{name,
+                  entt::hashed_string::value(name),
+                  {entt::type_hash<Owned>::value()...},
+                  {entt::type_hash<Get>::value()...},
+                  {&group::create, &group::size, &group::each,
+                   &group::each_entity}};
+
+  auto &groups = get_groups();
+  if (auto it = std::find_if(groups.begin(), groups.end(),
+                             [&info](const auto &g) { return g.id == info.id; });
+      it != groups.end()) {
+    *it = std::move(info);
+  } else {
+    groups.push_back(std::move(info));
+  }
+}
+
+// Unique type ids of arguments, kept inline (no heap allocation) for up to
+// inline_capacity types
+class type_set {
+  static constexpr std::size_t inline_capacity = 16;
+
+public:
+  explicit type_set(const sol::variadic_args &va) {
+    for (const auto &obj : va)
+      _insert(deduce_type(obj));
+  }
+
+  [[nodiscard]] const entt::id_type *begin() const {
+    return m_heap.empty() ? m_inline.data() : m_heap.data();
+  }
+  [[nodiscard]] const entt::id_type *end() const { return begin() + m_size; }
+  [[nodiscard]] std::size_t size() const { return m_size; }
+
+  [[nodiscard]] bool contains(entt::id_type type_id) const {
+    return std::find(begin(), end(), type_id) != end();
+  }
+
+private:
+  void _insert(entt::id_type type_id) {
+    if (contains(type_id)) return;
+    if (m_size < inline_capacity) {
+      m_inline[m_size] = type_id;
+    } else {
+      if (m_heap.empty()) m_heap.assign(m_inline.cbegin(), m_inline.cend());
+      m_heap.push_back(type_id);
+    }
+    ++m_size;
+  }
+
+private:
+  std::array<entt::id_type, inline_capacity> m_inline;
+  std::vector<entt::id_type> m_heap;
+  std::size_t m_size{0};
+};
+
+// Whether an entity has a component of a given type, straight from its
+// storage (no storage = no component)
+[[nodiscard]] inline bool has_type(const entt::registry &registry,
+                                   entt::entity entity,
+                                   entt::id_type type_id) {
+  const auto *storage = registry.storage(type_id);
+  return storage && storage->contains(entity);
+}
+inline auto to_entities(const sol::table &array) {
+  std::vector<entt::entity> entities(array.size());
+  for (std::size_t i = 0; i < entities.size(); ++i)
+    entities[i] = array.raw_get<entt::entity>(i + 1);
+  return entities;
+}
+// For range bindings (EnTT asserts on invalid or repeated entities), raises
+// a lua error instead
+inline std::vector<entt::entity>
+to_unique_entities(const entt::registry &registry, const sol::table &array,
+                   const char *binding) {
+  auto entities = to_entities(array);
+  for (std::size_t i = 0; i < entities.size(); ++i) {
+    if (!registry.valid(entities[i])) {
+      throw sol::error{std::string{"registry:"} + binding +
+                       ": invalid entity at " + std::to_string(i + 1)};
+    }
+  }
+  auto sorted = entities;
+  std::sort(sorted.begin(), sorted.end());
+  if (std::adjacent_find(sorted.cbegin(), sorted.cend()) != sorted.cend()) {
+    throw sol::error{std::string{"registry:"} + binding +
+                     ": repeated entity"};
+  }
+  return entities;
+}
+
+// Unlike type_set, preserves order of arguments (and duplicates)
+inline auto collect_types_ordered(const sol::variadic_args &va) {
+  std::vector<entt::id_type> types;
+  types.reserve(va.size());
+  std::transform(va.cbegin(), va.cend(), std::back_inserter(types),
                  [](const auto &obj) { return deduce_type(obj); });
   return types;
 }
 
-sol::table open_registry(sol::this_state s) {
+// Calls callback(entity, components...) for each entity of a query, every
+// component is pushed directly from its storage (one call per entity).
+inline void each_with_components(runtime_query &query,
+                                 const sol::function &callback) {
+  const auto *storages = query.storages();
+  if (!storages || !callback.valid()) return;
+
+  using column =
+    std::pair<decltype(component_dispatch::push), entt::sparse_set *>;
+  std::vector<column> columns;
+  columns.reserve(storages->size());
+  for (std::size_t i = 0; i < storages->size(); ++i) {
+    const auto *component = find_component_dispatch(query.types()[i]);
+    columns.emplace_back(component ? component->push : nullptr,
+                         (*storages)[i]);
+  }
+
+  lua_State *L = callback.lua_state();
+  const auto num_args = static_cast<int>(columns.size()) + 1;
+  query.each([&](entt::entity entity) {
+    callback.push(L);
+    sol::stack::push(L, entity);
+    for (auto [push, storage] : columns) {
+      if (push) {
+        push(L, storage, entity);
+      } else {
+        lua_pushnil(L);
+      }
+    }
+    lua_call(L, num_args, 0);
+  });
+}
+
+inline sol::table open_registry(sol::this_state s) {
   // To create a registry inside a script: entt.registry.new()
 
   sol::state_view lua{s};
@@ -81,6 +569,66 @@ sol::table open_registry(sol::this_state s) {
       }
   );
 
+  entt_module.new_usertype<runtime_query>("query",
+    sol::no_constructor,
+
+    "exclude",
+      [](runtime_query &self, const sol::variadic_args &va) -> runtime_query & {
+        const type_set types{va};
+        return self.exclude({types.begin(), types.end()});
+      },
+    "size_hint", &runtime_query::size_hint,
+    "contains", &runtime_query::contains,
+    // Passes entity and its components (in order of types given to query)
+    "each", &each_with_components,
+    "each_entity",
+      [](runtime_query &self, const sol::function &callback) {
+        if (callback.valid()) self.each(callback);
+      }
+  );
+
+  // Owning group registered with register_meta_group (see registry:group)
+  entt_module.new_usertype<runtime_group>("group",
+    sol::no_constructor,
+
+    // Passes entity, owned and then non-owned components
+    "each", &runtime_group::each,
+    "each_entity", &runtime_group::each_entity,
+    sol::meta_function::length, &runtime_group::size
+  );
+
+  // Entities touched since the last each (see registry:observe)
+  entt_module.new_usertype<runtime_observer>("observer",
+    sol::no_constructor,
+
+    "each",
+      [](runtime_observer &self, const sol::function &callback) {
+        PROFILER_ZONE("observer", "each");
+        if (callback.valid()) self.each(callback);
+      },
+    "clear", &runtime_observer::clear,
+    "disconnect", &runtime_observer::disconnect,
+    sol::meta_function::length, &runtime_observer::size
+  );
+
+  entt_module.new_usertype<entity_column>("entity_column",
+    sol::no_constructor,
+
+    sol::meta_function::index, &entity_column::get,
+    sol::meta_function::length, &entity_column::size
+  );
+  // for i = 1, #column do column[i] = column[i] + 1 end
+  entt_module.new_usertype<component_column>("column",
+    sol::no_constructor,
+    sol::base_classes, sol::bases<entity_column>(),
+
+    "entities", &component_column::entities,
+    "entity", &component_column::get,
+    sol::meta_function::index, &component_column::index,
+    sol::meta_function::new_index, &component_column::new_index,
+    sol::meta_function::length, &component_column::size
+  );
+
   using namespace entt::literals;
 
   entt_module.new_usertype<entt::registry>("registry",
@@ -88,78 +636,275 @@ sol::table open_registry(sol::this_state s) {
     sol::factories([]{ return entt::registry{}; }),
 
     "size", [](const entt::registry &self) {
+      PROFILER_ZONE("registry", "size");
       return self.storage<entt::entity>()->size();
     },
     "alive", [](const entt::registry &self) {
+      PROFILER_ZONE("registry", "alive");
       return self.storage<entt::entity>()->free_list();
     },
 
-    "valid", &entt::registry::valid,
-    "current", &entt::registry::current,
+    "valid", [](const entt::registry &self, entt::entity entity) {
+      PROFILER_ZONE("registry", "valid");
+      return self.valid(entity);
+    },
+    "current", [](const entt::registry &self, entt::entity entity) {
+      PROFILER_ZONE("registry", "current");
+      return self.current(entity);
+    },
 
-    "create", [](entt::registry &self) { return self.create(); },
+    "create", [](entt::registry &self) {
+      PROFILER_ZONE("registry", "create");
+      expect_registry_owner("create");
+      return self.create();
+    },
     "destroy",
       [](entt::registry &self, entt::entity entity) {
+        PROFILER_ZONE("registry", "destroy");
+        expect_registry_owner("destroy");
         return self.destroy(entity);
       },
 
+    // Bulk variants, each crosses the Lua/c++ boundary only once
+    "create_many",
+      [](entt::registry &self, std::size_t count) {
+        PROFILER_ZONE("registry", "create_many");
+        expect_registry_owner("create_many");
+        std::vector<entt::entity> entities(count);
+        self.create(entities.begin(), entities.end());
+        return sol::as_table(std::move(entities));
+      },
+    "destroy_many",
+      [](entt::registry &self, const sol::table &array) {
+        PROFILER_ZONE("registry", "destroy_many");
+        expect_registry_owner("destroy_many");
+        const auto entities = to_unique_entities(self, array, "destroy_many");
+        self.destroy(entities.cbegin(), entities.cend());
+      },
+    "emplace_many",
+      [](entt::registry &self, const sol::table &array,
+         const sol::object &type_or_id, const sol::object &instances) {
+        PROFILER_ZONE("registry", "emplace_many");
+        expect_registry_owner("emplace_many");
+        if (const auto *component =
+              find_component_dispatch(deduce_type(type_or_id));
+            component) {
+          component->emplace_many(
+            &self, to_unique_entities(self, array, "emplace_many"), instances);
+        }
+      },
+    "remove_many",
+      [](entt::registry &self, const sol::table &array,
+         const sol::object &type_or_id) {
+        PROFILER_ZONE("registry", "remove_many");
+        expect_registry_owner("remove_many");
+        const auto *component =
+          find_component_dispatch(deduce_type(type_or_id));
+        return component ? component->remove_many(&self, to_entities(array))
+                         : 0;
+      },
+    "clear_many",
+      [](entt::registry &self, const sol::variadic_args &va) {
+        PROFILER_ZONE("registry", "clear_many");
+        expect_registry_owner("clear_many");
+        for (auto type_id : type_set{va}) {
+          if (const auto *component = find_component_dispatch(type_id);
+              component) {
+            component->clear(&self);
+          }
+        }
+      },
+
     "emplace",
       [](entt::registry &self, entt::entity entity, const sol::table &comp,
          sol::this_state s) -> sol::object {
+        PROFILER_ZONE("registry", "emplace");
+        expect_registry_owner("emplace");
         if (!comp.valid()) return sol::lua_nil_t{};
-        const auto maybe_any = invoke_meta_func(get_type_id(comp), "emplace"_hs,
-          &self, entity, comp, s);
-        return maybe_any ? maybe_any.cast<sol::reference>() : sol::lua_nil_t{};
+        const auto *component = find_component_dispatch(deduce_type(comp));
+        return component ? component->emplace(&self, entity, comp, s)
+                         : sol::lua_nil_t{};
       },
     "remove",
       [](entt::registry &self, entt::entity entity, const sol::object &type_or_id) {
-        const auto maybe_any =
-          invoke_meta_func(deduce_type(type_or_id), "remove"_hs, &self, entity);
-        return maybe_any ? maybe_any.cast<size_t>() : 0;
+        PROFILER_ZONE("registry", "remove");
+        expect_registry_owner("remove");
+        const auto *component =
+          find_component_dispatch(deduce_type(type_or_id));
+        return component ? component->remove(&self, entity) : 0;
       },
     "has",
       [](entt::registry &self, entt::entity entity, const sol::object &type_or_id) {
-        const auto maybe_any =
-          invoke_meta_func(deduce_type(type_or_id), "has"_hs, &self, entity);
-        return maybe_any ? maybe_any.cast<bool>() : false;
+        PROFILER_ZONE("registry", "has");
+        const auto *component =
+          find_component_dispatch(deduce_type(type_or_id));
+        return component ? component->has(&self, entity) : false;
       },
+    // Multi-type checks, each type is tested directly in its storage
     "any_of",
-      [](const sol::table &self, entt::entity entity, const sol::variadic_args &va) {
-        const auto types = collect_types(va);
-        const auto has = self["has"].get<sol::function>();
-        return std::any_of(types.cbegin(), types.cend(),
-          [&](auto type_id) { return has(self, entity, type_id).template get<bool>(); }
-        );
+      [](const entt::registry &self, entt::entity entity,
+         const sol::variadic_args &va) {
+        PROFILER_ZONE("registry", "any_of");
+        const type_set types{va};
+        return std::any_of(types.begin(), types.end(), [&](auto type_id) {
+          return has_type(self, entity, type_id);
+        });
+      },
+    "all_of",
+      [](const entt::registry &self, entt::entity entity,
+         const sol::variadic_args &va) {
+        PROFILER_ZONE("registry", "all_of");
+        const type_set types{va};
+        return std::all_of(types.begin(), types.end(), [&](auto type_id) {
+          return has_type(self, entity, type_id);
+        });
+      },
+    "none_of",
+      [](const entt::registry &self, entt::entity entity,
+         const sol::variadic_args &va) {
+        PROFILER_ZONE("registry", "none_of");
+        const type_set types{va};
+        return std::none_of(types.begin(), types.end(), [&](auto type_id) {
+          return has_type(self, entity, type_id);
+        });
       },
     "get",
       [](entt::registry &self, entt::entity entity, const sol::object &type_or_id,
          sol::this_state s) {
-      const auto maybe_any =
-        invoke_meta_func(deduce_type(type_or_id), "get"_hs,
-          &self, entity, s);
-      return maybe_any ? maybe_any.cast<sol::reference>() : sol::lua_nil_t{};
+      PROFILER_ZONE("registry", "get");
+      const auto *component = find_component_dispatch(deduce_type(type_or_id));
+      return component ? component->get(&self, entity, s) : sol::lua_nil_t{};
     },
     "clear",
       sol::overload(
-        &entt::registry::clear<>,
+        [](entt::registry &self) {
+          PROFILER_ZONE("registry", "clear");
+          expect_registry_owner("clear");
+          self.clear();
+        },
         [](entt::registry &self, sol::object type_or_id) {
-          invoke_meta_func(deduce_type(type_or_id), "clear"_hs, &self);
+          PROFILER_ZONE("registry", "clear");
+          expect_registry_owner("clear");
+          if (const auto *component =
+                find_component_dispatch(deduce_type(type_or_id));
+              component) {
+            component->clear(&self);
+          }
         }
       ),
 
-    "orphan", &entt::registry::orphan,
+    "orphan", [](const entt::registry &self, entt::entity entity) {
+      PROFILER_ZONE("registry", "orphan");
+      return self.orphan(entity);
+    },
 
     "runtime_view",
       [](entt::registry &self, const sol::variadic_args &va) {
-        const auto types = collect_types(va);
+        PROFILER_ZONE("registry", "runtime_view");
+        const type_set types{va};
         
         auto view = entt::runtime_view{};
         for (auto &&[componentId, storage]: self.storage()) {
-          if (types.find(componentId) != types.cend()) {
+          if (types.contains(componentId)) {
             view.iterate(storage);
           }
         }
         return view;
+      },
+    // Runs a native kernel over all entities with given components, in lua:
+    // registry:apply("translate", {Transform}, dx, dy)
+    "apply",
+      [](entt::registry &self, const std::string &name,
+         const sol::table &components, const sol::variadic_args &args) {
+        PROFILER_ZONE("registry", "apply");
+        expect_registry_owner("apply");
+        std::vector<entt::id_type> types;
+        types.reserve(components.size());
+        for (std::size_t i = 1; i <= components.size(); ++i)
+          types.push_back(deduce_type(components.get<sol::object>(i)));
+        if (types.empty()) return false;
+
+        const auto *kernel =
+          find_kernel(entt::hashed_string::value(name.c_str()), types);
+        if (!kernel) return false;
+        kernel->invoke(self, args);
+        return true;
+      },
+    // Available kernels: { {name = "translate", types = {...}}, ... }
+    "kernels",
+      [](const entt::registry &, sol::this_state s) {
+        PROFILER_ZONE("registry", "kernels");
+        sol::state_view lua{s};
+        auto kernels = lua.create_table();
+        for (const auto &[name, types] : get_kernels()) {
+          kernels.add(lua.create_table_with(
+            "name", name, "types", sol::as_table(types)));
+        }
+        return kernels;
+      },
+
+    // Reflected data member of all components of a type (see column.hpp)
+    "column",
+      [](entt::registry &self, const sol::object &type_or_id,
+         const std::string &field) -> std::optional<component_column> {
+        PROFILER_ZONE("registry", "column");
+        expect_registry_owner("column");
+        const auto *component =
+          find_component_dispatch(deduce_type(type_or_id));
+        return component
+                 ? component->column(&self, entt::hashed_string::value(
+                                               field.c_str()))
+                 : std::nullopt;
+      },
+    // Unlike runtime_view, a query can be stored and iterated every frame
+    "query",
+      [](entt::registry &self, const sol::variadic_args &va) {
+        PROFILER_ZONE("registry", "query");
+        return runtime_query{self, collect_types_ordered(va)};
+      },
+    // Registered (by name) with register_meta_group, nil if there is none
+    "group",
+      [](entt::registry &self,
+         const std::string &name) -> std::optional<runtime_group> {
+        PROFILER_ZONE("registry", "group");
+        expect_registry_owner("group");
+        const auto *info = find_group(entt::hashed_string::value(name.c_str()));
+        if (!info) return std::nullopt;
+        return runtime_group{self, info->dispatch};
+      },
+    // registry:observe{ update = {Transform}, construct = {Transform} }
+    "observe",
+      [](entt::registry &self, const sol::table &events) {
+        PROFILER_ZONE("registry", "observe");
+        expect_registry_owner("observe");
+        auto observer = std::make_unique<runtime_observer>();
+        for (const auto &[name, event] :
+             {std::pair{"construct", observer_event::construct},
+              std::pair{"update", observer_event::update},
+              std::pair{"destroy", observer_event::destroy}}) {
+          const sol::optional<sol::table> types = events[name];
+          if (!types) continue;
+          for (const auto &[_, type_or_id] : *types) {
+            if (const auto *component =
+                  find_component_dispatch(deduce_type(type_or_id));
+                component) {
+              observer->connect(
+                component->observe(&self, event, observer.get()));
+            }
+          }
+        }
+        return observer;
+      },
+    // Binary snapshot (see snapshot.hpp), load requires an empty registry.
+    // Profiled by save_snapshot/load_snapshot
+    "save",
+      [](const entt::registry &self, const std::string &path) {
+        return save_snapshot(self, path);
+      },
+    "load",
+      [](entt::registry &self, const std::string &path, sol::this_state s) {
+        expect_registry_owner("load");
+        return load_snapshot(self, path, s);
       }
   );
   // clang-format on
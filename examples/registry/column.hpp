@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include "entt/entity/registry.hpp"
+#include "entt/meta/resolve.hpp"
+#include "sol/sol.hpp"
+#include "deferred_patch.hpp"
+
+// Numeric type of a reflected data member
+enum class column_type : std::uint8_t {
+  none,
+  boolean,
+  int32,
+  uint32,
+  int64,
+  float32,
+  float64
+};
+
+[[nodiscard]] inline column_type to_column_type(const entt::meta_type &type) {
+  if (!type) return column_type::none;
+  const auto id = type.info().hash();
+  if (id == entt::type_hash<bool>::value()) return column_type::boolean;
+  if (id == entt::type_hash<std::int32_t>::value()) return column_type::int32;
+  if (id == entt::type_hash<std::uint32_t>::value())
+    return column_type::uint32;
+  if (id == entt::type_hash<std::int64_t>::value()) return column_type::int64;
+  if (id == entt::type_hash<float>::value()) return column_type::float32;
+  if (id == entt::type_hash<double>::value()) return column_type::float64;
+  return column_type::none;
+}
+[[nodiscard]] constexpr std::size_t size_of(column_type type) {
+  switch (type) {
+  case column_type::boolean:
+    return sizeof(bool);
+  case column_type::int32:
+  case column_type::uint32:
+  case column_type::float32:
+    return 4;
+  case column_type::int64:
+  case column_type::float64:
+    return 8;
+  default:
+    break;
+  }
+  return 0;
+}
+
+// Entities of a storage (packed array), 1-based.
+// Slots of removed components (in_place_delete) yield nil.
+class entity_column {
+public:
+  explicit entity_column(entt::sparse_set &storage) : m_storage{&storage} {}
+
+  [[nodiscard]] std::size_t size() const { return m_storage->size(); }
+  [[nodiscard]] std::optional<entt::entity> get(std::size_t i) const {
+    if (i < 1 || i > size()) return std::nullopt;
+    const auto entity = m_storage->data()[i - 1];
+    if (entity == entt::tombstone) return std::nullopt;
+    return entity;
+  }
+
+protected:
+  entt::sparse_set *m_storage;
+};
+
+// Single field of every component in a storage, 1-based, in order of
+// entity_column. Elements are read/written in place (storage is paged, so
+// only elements of the same page are contiguous), without meta dispatch.
+// A write patches the component (emits on_update, @see request_patch).
+class component_column : public entity_column {
+public:
+  // Address of a component at a given position in a (typed) storage
+  using accessor = void *(*)(entt::sparse_set &, std::size_t);
+  using patcher = void (*)(entt::sparse_set &, entt::entity);
+
+  component_column(entt::sparse_set &storage, accessor at, patcher patch,
+                   std::size_t offset, column_type type)
+      : entity_column{storage}, m_at{at}, m_patch{patch}, m_offset{offset},
+        m_type{type} {}
+
+  [[nodiscard]] entity_column entities() const { return *this; }
+
+  // lua: column[i], nil for out of range index or a removed component
+  static int index(lua_State *L) {
+    const auto &self = sol::stack::get<const component_column &>(L, 1);
+    const auto i = static_cast<std::size_t>(luaL_checkinteger(L, 2));
+    if (!self.get(i)) {
+      lua_pushnil(L);
+      return 1;
+    }
+    const auto *field = self._field(i);
+    switch (self.m_type) {
+    case column_type::boolean:
+      lua_pushboolean(L, self._read<bool>(field));
+      break;
+    case column_type::int32:
+      lua_pushinteger(L, self._read<std::int32_t>(field));
+      break;
+    case column_type::uint32:
+      lua_pushinteger(L, self._read<std::uint32_t>(field));
+      break;
+    case column_type::int64:
+      lua_pushinteger(L,
+                      static_cast<lua_Integer>(self._read<std::int64_t>(field)));
+      break;
+    case column_type::float32:
+      lua_pushnumber(L, self._read<float>(field));
+      break;
+    case column_type::float64:
+      lua_pushnumber(L, self._read<double>(field));
+      break;
+    default:
+      lua_pushnil(L);
+      break;
+    }
+    return 1;
+  }
+  // lua: column[i] = value
+  static int new_index(lua_State *L) {
+    auto &self = sol::stack::get<component_column &>(L, 1);
+    const auto i = static_cast<std::size_t>(luaL_checkinteger(L, 2));
+    const auto entity = self.get(i);
+    if (!entity) {
+      return luaL_error(L, "column index out of range: %d",
+                        static_cast<int>(i));
+    }
+
+    auto *field = self._field(i);
+    switch (self.m_type) {
+    case column_type::boolean:
+      _write(field, static_cast<bool>(lua_toboolean(L, 3)));
+      break;
+    case column_type::int32:
+      _write(field, static_cast<std::int32_t>(luaL_checkinteger(L, 3)));
+      break;
+    case column_type::uint32:
+      _write(field, static_cast<std::uint32_t>(luaL_checkinteger(L, 3)));
+      break;
+    case column_type::int64:
+      _write(field, static_cast<std::int64_t>(luaL_checkinteger(L, 3)));
+      break;
+    case column_type::float32:
+      _write(field, static_cast<float>(luaL_checknumber(L, 3)));
+      break;
+    case column_type::float64:
+      _write(field, static_cast<double>(luaL_checknumber(L, 3)));
+      break;
+    default:
+      break;
+    }
+    request_patch(*self.m_storage, *entity, self.m_patch);
+    return 0;
+  }
+
+private:
+  [[nodiscard]] std::byte *_field(std::size_t i) const {
+    return static_cast<std::byte *>(m_at(*m_storage, i - 1)) + m_offset;
+  }
+  template <typename T> [[nodiscard]] static T _read(const std::byte *field) {
+    T value;
+    std::memcpy(&value, field, sizeof(T));
+    return value;
+  }
+  template <typename T> static void _write(std::byte *field, T value) {
+    std::memcpy(field, &value, sizeof(T));
+  }
+
+private:
+  accessor m_at;
+  patcher m_patch;
+  std::size_t m_offset;
+  column_type m_type;
+};
+
+template <typename Component>
+void *component_at(entt::sparse_set &set, std::size_t pos) {
+  constexpr auto page_size = entt::component_traits<Component>::page_size;
+  auto &storage = static_cast<entt::storage_for_t<Component> &>(set);
+  return &storage.raw()[pos / page_size][pos % page_size];
+}
+
+// Column of a reflected data member, the member has to be reflected by
+// reference (entt::as_ref_t), @see register_meta_data
+template <typename Component>
+std::optional<component_column> make_column(entt::registry *registry,
+                                            entt::id_type field_id) {
+  assert(registry);
+  if constexpr (entt::component_traits<Component>::page_size == 0) {
+    return std::nullopt; // Empty type, no payload
+  } else {
+    const auto data = entt::resolve<Component>().data(field_id);
+    if (!data) return std::nullopt;
+    const auto type = to_column_type(data.type());
+    if (type == column_type::none) return std::nullopt;
+
+    // Offset of the member, from a reference to a field of a probe
+    Component probe{};
+    auto field = data.get(probe);
+    const auto base = reinterpret_cast<std::uintptr_t>(&probe);
+    const auto address = reinterpret_cast<std::uintptr_t>(field.data());
+    if (address < base || address + size_of(type) > base + sizeof(Component))
+      return std::nullopt; // Reflected by value
+
+    return component_column{registry->storage<Component>(),
+                            &component_at<Component>,
+                            &component_patch<Component>, address - base, type};
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include "entt/entity/registry.hpp"
+
+// Patches (on_update) requested by writes through proxies and columns.
+// Signals of a registry are not thread safe, so a thread other than the main
+// one (e.g. script_workers) collects its patches and the main thread
+// replays them afterwards.
+class deferred_patches {
+public:
+  using patcher = void (*)(entt::sparse_set &, entt::entity);
+
+  // Patches of the calling thread go there (if set)
+  [[nodiscard]] static deferred_patches *&current() {
+    thread_local deferred_patches *patches{nullptr};
+    return patches;
+  }
+
+  void push(entt::sparse_set &storage, entt::entity entity, patcher patch) {
+    m_patches.push_back({&storage, entity, patch});
+  }
+  // Components removed in the meantime are skipped
+  void replay() {
+    for (const auto &p : std::exchange(m_patches, {})) {
+      if (p.storage->contains(p.entity)) p.patch(*p.storage, p.entity);
+    }
+  }
+
+private:
+  struct entry {
+    entt::sparse_set *storage;
+    entt::entity entity;
+    patcher patch;
+  };
+  std::vector<entry> m_patches;
+};
+
+// Calling thread doesn't own the registry (e.g. a script worker), it may
+// read and modify components but not make structural changes
+[[nodiscard]] inline bool on_worker_thread() {
+  return deferred_patches::current() != nullptr;
+}
+
+template <typename Component>
+void component_patch(entt::sparse_set &set, entt::entity entity) {
+  static_cast<entt::storage_for_t<Component> &>(set).patch(entity);
+}
+// Right away, or deferred if the calling thread collects its patches
+inline void request_patch(entt::sparse_set &storage, entt::entity entity,
+                          deferred_patches::patcher patch) {
+  if (auto *patches = deferred_patches::current(); patches) {
+    patches->push(storage, entity, patch);
+  } else {
+    patch(storage, entity);
+  }
+}
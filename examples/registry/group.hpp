@@ -0,0 +1,62 @@
+#pragma once
+
+#include "entt/core/hashed_string.hpp"
+#include "entt/entity/registry.hpp"
+#include "sol/sol.hpp"
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <vector>
+
+// Type-erased owning group, set up by register_meta_group
+struct group_dispatch {
+  void (*create)(entt::registry &);
+  std::size_t (*size)(entt::registry &);
+  // callback(entity, owned..., get...)
+  void (*each)(entt::registry &, const sol::function &);
+  void (*each_entity)(entt::registry &, const sol::function &);
+};
+
+struct group_info {
+  std::string name;
+  entt::id_type id;
+  std::vector<entt::id_type> owned;
+  std::vector<entt::id_type> get;
+  group_dispatch dispatch;
+};
+[[nodiscard]] inline std::vector<group_info> &get_groups() {
+  static std::vector<group_info> groups;
+  return groups;
+}
+[[nodiscard]] inline const group_info *find_group(entt::id_type id) {
+  const auto &groups = get_groups();
+  const auto it = std::find_if(groups.cbegin(), groups.cend(),
+                               [id](const auto &info) { return info.id == id; });
+  return it != groups.cend() ? &*it : nullptr;
+}
+
+// Group of a registry, @see registry:group
+// The group itself is owned (and kept sorted) by the registry, which must
+// outlive the handle.
+class runtime_group {
+public:
+  runtime_group(entt::registry &registry, const group_dispatch &dispatch)
+      : m_registry{&registry}, m_dispatch{dispatch} {
+    m_dispatch.create(*m_registry);
+  }
+
+  [[nodiscard]] std::size_t size() const {
+    return m_dispatch.size(*m_registry);
+  }
+
+  void each(const sol::function &callback) const {
+    if (callback.valid()) m_dispatch.each(*m_registry, callback);
+  }
+  void each_entity(const sol::function &callback) const {
+    if (callback.valid()) m_dispatch.each_entity(*m_registry, callback);
+  }
+
+private:
+  entt::registry *m_registry;
+  group_dispatch m_dispatch;
+};
@@ -1,5 +1,6 @@
 #include "bond.hpp"
 #include "../common/transform.hpp"
+#include "../common/velocity.hpp"
 
 #define AUTO_ARG(x) decltype(x), x
 
@@ -12,11 +13,17 @@ int main(int argc, char *argv[]) {
 
   try {
     register_meta_component<Transform>();
+    register_meta_data<Transform, &Transform::x>("x");
+    register_meta_data<Transform, &Transform::y>("y");
+    register_meta_kernel<&translate, Transform>("translate");
+    register_meta_component<Velocity>();
+    register_meta_group<Velocity>("movement", entt::get<Transform>);
 
     sol::state lua{};
     lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::string);
     lua.require("registry", sol::c_call<AUTO_ARG(&open_registry)>, false);
     register_transform(lua); // Make Transform struct available to Lua
+    register_velocity(lua);
 
     entt::registry registry{};
     lua["registry"] = std::ref(registry); // Make the registry available to Lua
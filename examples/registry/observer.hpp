@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "entt/entity/registry.hpp"
+#include "entt/signal/sigh.hpp"
+
+// Signals of a component storage, @see registry:observe
+enum class observer_event : std::uint8_t { construct, update, destroy };
+
+// Collects entities touched by signals of observed types, each at most once,
+// until they are drained with each(). Unlike entt::observer, types are known
+// at runtime. The registry must outlive the connections.
+class runtime_observer {
+public:
+  runtime_observer() = default;
+  runtime_observer(const runtime_observer &) = delete;
+
+  runtime_observer &operator=(const runtime_observer &) = delete;
+
+  // Keeps the connection for the lifetime of the observer
+  void connect(const entt::connection &connection) {
+    m_connections.emplace_back(connection);
+  }
+  void disconnect() { m_connections.clear(); }
+
+  // Signal handler (construct, update or destroy)
+  // A destroyed entity whose index is recycled before the drain is replaced
+  // by the new one (same slot, newer version).
+  void touch(entt::registry &, entt::entity entity) {
+    if (m_touched.current(entity) == entt::to_version(entt::tombstone)) {
+      m_touched.push(entity);
+    } else if (!m_touched.contains(entity)) {
+      m_touched.bump(entity);
+    }
+  }
+
+  [[nodiscard]] std::size_t size() const { return m_touched.size(); }
+  void clear() { m_touched.clear(); }
+
+  // Visits entities touched since the last drain, then forgets them.
+  // Entities are not filtered, those observed on destroy (or destroyed
+  // since) are reported as well, check registry:valid if needed.
+  // Entities touched by func are collected for the next drain.
+  template <typename Func> void each(Func &&func) {
+    std::swap(m_touched, m_draining);
+    // Drained even if func throws, otherwise it would be visited again
+    struct drain_guard {
+      entt::sparse_set &set;
+      ~drain_guard() { set.clear(); }
+    } guard{m_draining};
+    for (auto entity : m_draining)
+      func(entity);
+  }
+
+private:
+  entt::sparse_set m_touched;
+  entt::sparse_set m_draining;
+  std::vector<entt::scoped_connection> m_connections;
+};
+
+template <typename Component>
+entt::connection observe_component(entt::registry *registry,
+                                   observer_event event,
+                                   runtime_observer *observer) {
+  assert(registry && observer);
+  switch (event) {
+  case observer_event::construct:
+    return registry->on_construct<Component>()
+      .template connect<&runtime_observer::touch>(*observer);
+  case observer_event::update:
+    return registry->on_update<Component>()
+      .template connect<&runtime_observer::touch>(*observer);
+  case observer_event::destroy:
+    return registry->on_destroy<Component>()
+      .template connect<&runtime_observer::touch>(*observer);
+  }
+  return entt::connection{};
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "entt/entity/registry.hpp"
+#include "entt/entity/runtime_view.hpp"
+#include <algorithm>
+#include <vector>
+
+// Persistent runtime_view, keeps storage pointers between calls.
+// Types without storage (nothing emplaced yet) are kept aside and checked
+// on access, the view is rebuilt only when one of them shows up.
+class runtime_query {
+public:
+  runtime_query(entt::registry &registry, std::vector<entt::id_type> include)
+      : m_registry{&registry}, m_include{std::move(include)} {
+    _build();
+  }
+
+  runtime_query &exclude(const std::vector<entt::id_type> &types) {
+    m_exclude.insert(m_exclude.cend(), types.cbegin(), types.cend());
+    _build();
+    return *this;
+  }
+
+  [[nodiscard]] std::size_t size_hint() {
+    return _ready() ? m_view.size_hint() : 0;
+  }
+  [[nodiscard]] bool contains(entt::entity entity) {
+    return _ready() && m_view.contains(entity);
+  }
+
+  // Storages of included types (same order), nullptr if any is missing
+  [[nodiscard]] const std::vector<entt::sparse_set *> *storages() {
+    return _ready() ? &m_storages : nullptr;
+  }
+  [[nodiscard]] const std::vector<entt::id_type> &types() const {
+    return m_include;
+  }
+
+  template <typename Func> void each(Func &&func) {
+    if (!_ready()) return;
+    for (auto entity : m_view)
+      func(entity);
+  }
+
+private:
+  [[nodiscard]] bool _ready() {
+    _refresh();
+    return m_missing == 0;
+  }
+  void _refresh() {
+    const auto created = std::any_of(
+      m_pending.cbegin(), m_pending.cend(), [this](auto type_id) {
+        return m_registry->storage(type_id) != nullptr;
+      });
+    if (created) _build();
+  }
+  void _build() {
+    m_view = entt::runtime_view{};
+    m_storages.clear();
+    m_pending.clear();
+    m_missing = 0;
+
+    for (auto type_id : m_include) {
+      if (auto *storage = m_registry->storage(type_id); storage) {
+        m_view.iterate(*storage);
+        m_storages.push_back(storage);
+      } else {
+        m_pending.push_back(type_id);
+        ++m_missing;
+      }
+    }
+    for (auto type_id : m_exclude) {
+      if (auto *storage = m_registry->storage(type_id); storage) {
+        m_view.exclude(*storage);
+      } else {
+        m_pending.push_back(type_id);
+      }
+    }
+    if (m_include.empty()) ++m_missing;
+  }
+
+private:
+  entt::registry *m_registry;
+  std::vector<entt::id_type> m_include;
+  std::vector<entt::id_type> m_exclude;
+
+  entt::runtime_view m_view;
+  std::vector<entt::sparse_set *> m_storages;
+  std::vector<entt::id_type> m_pending; // Types without storage (yet)
+  std::size_t m_missing{0};             // Included types without storage
+};
@@ -0,0 +1,436 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "entt/entity/registry.hpp"
+#include "entt/entity/snapshot.hpp"
+#include "mapped_file.hpp"
+#include "meta_helper.hpp"
+#include "profiler.hpp"
+
+// Binary snapshot of a registry:
+//  header | entities | component sections
+// section: type id (u32) | payload size (u64) | payload
+// Payloads are entt::snapshot streams, components are written with
+// component_serializer (memcpy for trivially copyable types).
+namespace snapshot_format {
+
+inline constexpr char magic[4]{'E', 'S', 'N', 'P'};
+inline constexpr std::uint32_t version{2};
+inline constexpr int max_depth{16}; // Of nested lua tables
+
+struct header {
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t count; // Sections (entities included)
+};
+
+// Lua values, @see snapshot_writer::write_value
+enum class lua_tag : std::uint8_t {
+  nil,
+  boolean_false,
+  boolean_true,
+  integer,
+  number,
+  string,
+  table,
+  end, // Of a table
+  ref  // Table written before (within the same value), index (u32)
+};
+
+} // namespace snapshot_format
+
+class snapshot_writer;
+class snapshot_reader;
+
+// Specialize for components that are not trivially copyable, e.g.
+// template <> struct component_serializer<Foo> {
+//   static void save(snapshot_writer &, const Foo &);
+//   static void load(snapshot_reader &, Foo &);
+// };
+template <typename Component> struct component_serializer {
+  static_assert(std::is_trivially_copyable_v<Component>,
+                "Specialize component_serializer");
+
+  static void save(snapshot_writer &writer, const Component &value);
+  static void load(snapshot_reader &reader, Component &value);
+};
+
+// Output archive of entt::snapshot, into a single buffer (grows
+// geometrically, no allocation per entity)
+class snapshot_writer {
+  using lua_tag = snapshot_format::lua_tag;
+
+public:
+  void operator()(entt::entity entity) {
+    // A removed component (in_place_delete) is not read back
+    m_skip = entity == entt::tombstone;
+    write(entity);
+  }
+  void operator()(std::underlying_type_t<entt::entity> value) { write(value); }
+  template <typename Component> void operator()(const Component &value) {
+    if (!std::exchange(m_skip, false))
+      component_serializer<Component>::save(*this, value);
+  }
+
+  void write(const void *data, std::size_t size) {
+    const auto offset = m_buffer.size();
+    m_buffer.resize(offset + size);
+    std::memcpy(m_buffer.data() + offset, data, size);
+  }
+  template <typename T> void write(const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    write(&value, sizeof(T));
+  }
+  // Data portion of a lua value: nil, booleans, numbers, strings and tables
+  // of them. Functions, userdata and threads are written as nil (skipped in
+  // tables). Nested tables are copied (up to max_depth), a table reachable
+  // more than once (shared or a cycle) is written once and then referenced,
+  // so read_value restores the same graph.
+  void write_value(lua_State *L, int index) {
+    m_tables.clear();
+    _write_value(L, index, 0);
+  }
+
+  [[nodiscard]] std::size_t size() const { return m_buffer.size(); }
+  [[nodiscard]] std::byte *data() { return m_buffer.data(); }
+  [[nodiscard]] const std::vector<std::byte> &buffer() const {
+    return m_buffer;
+  }
+
+private:
+  void _write_value(lua_State *L, int index, int depth) {
+    index = lua_absindex(L, index);
+    switch (lua_type(L, index)) {
+    case LUA_TBOOLEAN:
+      write(lua_toboolean(L, index) ? lua_tag::boolean_true
+                                    : lua_tag::boolean_false);
+      break;
+    case LUA_TNUMBER:
+#if LUA_VERSION_NUM >= 503
+      if (lua_isinteger(L, index)) {
+        write(lua_tag::integer);
+        write(static_cast<std::int64_t>(lua_tointeger(L, index)));
+        break;
+      }
+#endif
+      write(lua_tag::number);
+      write(static_cast<double>(lua_tonumber(L, index)));
+      break;
+    case LUA_TSTRING: {
+      std::size_t length{0};
+      const auto *str = lua_tolstring(L, index, &length);
+      write(lua_tag::string);
+      write(static_cast<std::uint32_t>(length));
+      write(str, length);
+    } break;
+    case LUA_TTABLE: {
+      const auto [it, inserted] = m_tables.try_emplace(
+        lua_topointer(L, index), static_cast<std::uint32_t>(m_tables.size()));
+      if (!inserted) {
+        write(lua_tag::ref);
+        write(it->second);
+        break;
+      }
+      if (depth >= snapshot_format::max_depth || !lua_checkstack(L, 2)) {
+        m_tables.erase(it);
+        write(lua_tag::nil);
+        break;
+      }
+      write(lua_tag::table);
+      lua_pushnil(L);
+      while (lua_next(L, index)) {
+        if (_is_key(lua_type(L, -2)) && _is_data(lua_type(L, -1))) {
+          _write_value(L, -2, depth + 1);
+          _write_value(L, -1, depth + 1);
+        }
+        lua_pop(L, 1);
+      }
+      write(lua_tag::end);
+    } break;
+    default:
+      write(lua_tag::nil);
+      break;
+    }
+  }
+
+  [[nodiscard]] static bool _is_key(int type) {
+    return type == LUA_TBOOLEAN || type == LUA_TNUMBER || type == LUA_TSTRING;
+  }
+  [[nodiscard]] static bool _is_data(int type) {
+    return _is_key(type) || type == LUA_TTABLE;
+  }
+
+private:
+  std::vector<std::byte> m_buffer;
+  bool m_skip{false};
+  // Tables of the current value (write order), @see write_value
+  std::unordered_map<const void *, std::uint32_t> m_tables;
+};
+
+// Input archive of entt::snapshot_loader, reads straight from memory (a
+// mapped file). Reading past the end fails the reader (values are left
+// untouched).
+class snapshot_reader {
+  using lua_tag = snapshot_format::lua_tag;
+
+public:
+  snapshot_reader(const std::byte *data, std::size_t size, lua_State *L,
+                  entt::registry &registry)
+      : m_data{data}, m_size{size}, m_state{L}, m_registry{registry} {}
+
+  void operator()(entt::entity &entity) { read(entity); }
+  void operator()(std::underlying_type_t<entt::entity> &value) { read(value); }
+  template <typename Component> void operator()(Component &value) {
+    component_serializer<Component>::load(*this, value);
+  }
+
+  bool read(void *data, std::size_t size) {
+    if (const auto *src = _take(size); src) {
+      std::memcpy(data, src, size);
+      return true;
+    }
+    return false;
+  }
+  template <typename T> bool read(T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return read(&value, sizeof(T));
+  }
+  // Pushes a value written by snapshot_writer::write_value (nil on error)
+  void read_value(lua_State *L) {
+    // Tables of the value (read order), targets of refs
+    lua_newtable(L);
+    const auto tables = lua_gettop(L);
+    std::uint32_t count{0};
+    _read_value(L, 0, tables, count);
+    lua_remove(L, tables);
+  }
+
+  [[nodiscard]] lua_State *lua_state() const { return m_state; }
+  [[nodiscard]] entt::registry &registry() const { return m_registry; }
+
+  [[nodiscard]] bool failed() const { return m_failed; }
+  [[nodiscard]] std::size_t position() const { return m_position; }
+  void seek(std::size_t position) {
+    if (position > m_size) {
+      m_failed = true;
+    } else {
+      m_position = position;
+    }
+  }
+
+private:
+  void _read_value(lua_State *L, int depth, int tables,
+                   std::uint32_t &count) {
+    auto tag = lua_tag::nil;
+    read(tag);
+    if (tag == lua_tag::table &&
+        (depth >= snapshot_format::max_depth || !lua_checkstack(L, 4))) {
+      m_failed = true;
+    }
+    if (m_failed) tag = lua_tag::nil;
+
+    switch (tag) {
+    case lua_tag::boolean_false:
+    case lua_tag::boolean_true:
+      lua_pushboolean(L, tag == lua_tag::boolean_true);
+      break;
+    case lua_tag::integer: {
+      std::int64_t value{0};
+      read(value);
+      lua_pushinteger(L, static_cast<lua_Integer>(value));
+    } break;
+    case lua_tag::number: {
+      double value{0};
+      read(value);
+      lua_pushnumber(L, static_cast<lua_Number>(value));
+    } break;
+    case lua_tag::string: {
+      std::uint32_t length{0};
+      read(length);
+      if (const auto *str = _take(length); str) {
+        lua_pushlstring(L, reinterpret_cast<const char *>(str), length);
+      } else {
+        lua_pushnil(L);
+      }
+    } break;
+    case lua_tag::table:
+      lua_newtable(L);
+      // Before its fields, a table might refer to itself
+      lua_pushvalue(L, -1);
+      lua_rawseti(L, tables, static_cast<lua_Integer>(++count));
+      while (!m_failed && _peek() != lua_tag::end) {
+        _read_value(L, depth + 1, tables, count); // Key
+        _read_value(L, depth + 1, tables, count); // Value
+        if (lua_isnil(L, -2)) {
+          lua_pop(L, 2);
+        } else {
+          lua_rawset(L, -3);
+        }
+      }
+      static_cast<void>(_take(1)); // End tag
+      break;
+    case lua_tag::ref: {
+      std::uint32_t index{0};
+      read(index);
+      if (m_failed || index >= count) {
+        m_failed = true;
+        lua_pushnil(L);
+      } else {
+        lua_rawgeti(L, tables, static_cast<lua_Integer>(index) + 1);
+      }
+    } break;
+    default:
+      lua_pushnil(L);
+      break;
+    }
+  }
+
+  [[nodiscard]] const std::byte *_take(std::size_t size) {
+    if (m_failed || size > m_size - m_position) {
+      m_failed = true;
+      return nullptr;
+    }
+    return m_data + std::exchange(m_position, m_position + size);
+  }
+  [[nodiscard]] lua_tag _peek() const {
+    return m_position < m_size ? static_cast<lua_tag>(m_data[m_position])
+                               : lua_tag::end;
+  }
+
+private:
+  const std::byte *m_data;
+  const std::size_t m_size;
+  std::size_t m_position{0};
+  bool m_failed{false};
+
+  lua_State *m_state;
+  entt::registry &m_registry;
+};
+
+template <typename Component>
+void component_serializer<Component>::save(snapshot_writer &writer,
+                                           const Component &value) {
+  writer.write(value);
+}
+template <typename Component>
+void component_serializer<Component>::load(snapshot_reader &reader,
+                                           Component &value) {
+  reader.read(value);
+}
+
+// Typed entry points of a serializable component, @see dispatch_cache
+struct snapshot_dispatch {
+  static constexpr auto id = entt::hashed_string::value("snapshot_dispatch");
+
+  void (*save)(const entt::snapshot &, snapshot_writer &);
+  void (*load)(entt::snapshot_loader &, snapshot_reader &);
+};
+template <typename Component>
+const snapshot_dispatch *get_snapshot_dispatch() {
+  static constexpr snapshot_dispatch table{
+    [](const entt::snapshot &snapshot, snapshot_writer &writer) {
+      snapshot.get<Component>(writer);
+    },
+    [](entt::snapshot_loader &loader, snapshot_reader &reader) {
+      loader.get<Component>(reader);
+    },
+  };
+  return &table;
+}
+
+// Called by register_meta_component for trivially copyable components,
+// others need a component_serializer first
+template <typename Component> void register_meta_snapshot() {
+  entt::meta<Component>().template func<&get_snapshot_dispatch<Component>>(
+    snapshot_dispatch::id);
+
+  invalidate_dispatch_caches();
+}
+
+// Entities and every component with a snapshot_dispatch
+inline bool save_snapshot(const entt::registry &registry,
+                          const std::filesystem::path &p) {
+  PROFILER_ZONE("registry", "save");
+  using namespace snapshot_format;
+
+  snapshot_writer writer;
+  header hdr{};
+  std::memcpy(hdr.magic, magic, sizeof(magic));
+  hdr.version = version;
+  writer.write(hdr);
+
+  const entt::snapshot snapshot{registry};
+  const auto write_section = [&](entt::id_type type_id, auto &&save) {
+    writer.write(static_cast<std::uint32_t>(type_id));
+    const auto size_offset = writer.size();
+    writer.write(std::uint64_t{0});
+    save();
+    const std::uint64_t size =
+      writer.size() - size_offset - sizeof(std::uint64_t);
+    std::memcpy(writer.data() + size_offset, &size, sizeof(size));
+    ++hdr.count;
+  };
+  write_section(entt::type_hash<entt::entity>::value(),
+                [&] { snapshot.get<entt::entity>(writer); });
+  for (auto &&[id, type] : entt::resolve()) {
+    const auto type_id = type.info().hash();
+    if (!registry.storage(type_id)) continue;
+    if (const auto *dispatch = dispatch_cache<snapshot_dispatch>::find(type_id);
+        dispatch) {
+      write_section(type_id, [&] { dispatch->save(snapshot, writer); });
+    }
+  }
+  std::memcpy(writer.data(), &hdr, sizeof(hdr));
+
+  std::ofstream f{p, std::ios::binary};
+  f.write(reinterpret_cast<const char *>(writer.buffer().data()),
+          static_cast<std::streamsize>(writer.size()));
+  return f.good();
+}
+
+// Into an empty registry. Components without a snapshot_dispatch are
+// skipped. L is used to restore lua values (e.g. script data).
+inline bool load_snapshot(entt::registry &registry,
+                          const std::filesystem::path &p, lua_State *L) {
+  PROFILER_ZONE("registry", "load");
+  using namespace snapshot_format;
+
+  if (!registry.storage<entt::entity>().empty()) return false;
+
+  mapped_file file;
+  if (!file.open(p)) return false;
+  snapshot_reader reader{reinterpret_cast<const std::byte *>(file.data()),
+                         file.size(), L, registry};
+
+  header hdr{};
+  if (!reader.read(hdr) || std::memcmp(hdr.magic, magic, sizeof(magic)) != 0 ||
+      hdr.version != version) {
+    return false;
+  }
+
+  entt::snapshot_loader loader{registry};
+  for (std::uint32_t i = 0; i < hdr.count && !reader.failed(); ++i) {
+    std::uint32_t type_id{0};
+    std::uint64_t size{0};
+    reader.read(type_id);
+    reader.read(size);
+    const auto end = reader.position() + static_cast<std::size_t>(size);
+
+    if (type_id == entt::type_hash<entt::entity>::value()) {
+      loader.get<entt::entity>(reader);
+    } else if (const auto *dispatch =
+                 dispatch_cache<snapshot_dispatch>::find(type_id);
+               dispatch) {
+      dispatch->load(loader, reader);
+    }
+    reader.seek(end);
+  }
+  return !reader.failed();
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "entt/process/scheduler.hpp"
+#include "coroutine_process.hpp"
+#include "parallel_scheduler.hpp"
+#include "profiler.hpp"
+#include "wheel_scheduler.hpp"
+
+using scheduler = entt::basic_scheduler<fsec>;
+
+// Process is either a table (script_process) or a function
+// (coroutine_process, not supported by wheel_scheduler)
+[[nodiscard]] inline bool is_coroutine(const sol::object &process) {
+  return process.get_type() == sol::type::function;
+}
+// attach(process).then(child_process) ... of entt::scheduler and
+// parallel_scheduler
+template <typename Scheduler>
+void attach_script_processes(Scheduler &scheduler, const sol::object &process,
+                             const sol::variadic_args &va) {
+  auto &continuator =
+    is_coroutine(process)
+      ? scheduler.template attach<coroutine_process>(process.as<sol::function>())
+      : scheduler.template attach<script_process>(process.as<sol::table>());
+  for (sol::object child_process : va) {
+    if (is_coroutine(child_process)) {
+      continuator.template then<coroutine_process>(
+        child_process.as<sol::function>());
+    } else {
+      continuator.template then<script_process>(
+        child_process.as<sol::table>());
+    }
+  }
+}
+
+[[nodiscard]] inline sol::table open_scheduler(sol::this_state s) {
+  // To create a scheduler inside a script: entt.scheduler.new(),
+  // entt.wheel_scheduler.new() or entt.parallel_scheduler.new()
+
+  sol::state_view lua{s};
+  auto entt_module = lua["entt"].get_or_create<sol::table>();
+
+  // clang-format off
+  entt_module.new_usertype<scheduler>("scheduler",
+    sol::meta_function::construct,
+    sol::factories([]{ return scheduler{}; }),
+
+    "size", &scheduler::size,
+    "empty", &scheduler::empty,
+    "clear",
+      [](scheduler &self) {
+        PROFILER_ZONE("scheduler", "clear");
+        self.clear();
+      },
+    "attach",
+      [](scheduler &self, const sol::object &process,
+         const sol::variadic_args &va) {
+        PROFILER_ZONE("scheduler", "attach");
+        // TODO: validate process before attach?
+        attach_script_processes(self, process, va);
+      },
+    "update",
+      [](scheduler &self, fsec dt, void *data) {
+        PROFILER_ZONE("scheduler", "update");
+        self.update(dt, data);
+      },
+    "abort",
+      sol::overload(
+        [](scheduler &self) {
+          PROFILER_ZONE("scheduler", "abort");
+          self.abort();
+        },
+        [](scheduler &self, bool immediately) {
+          PROFILER_ZONE("scheduler", "abort");
+          self.abort(immediately);
+        }
+      )
+  );
+
+  // Same interface as above, only due processes are updated
+  entt_module.new_usertype<wheel_scheduler>("wheel_scheduler",
+    sol::meta_function::construct,
+    sol::factories([]{ return wheel_scheduler{}; }),
+
+    "size", &wheel_scheduler::size,
+    "empty", &wheel_scheduler::empty,
+    "clear",
+      [](wheel_scheduler &self) {
+        PROFILER_ZONE("wheel_scheduler", "clear");
+        self.clear();
+      },
+    "attach",
+      [](wheel_scheduler &self, const sol::table &process,
+         const sol::variadic_args &va) {
+        PROFILER_ZONE("wheel_scheduler", "attach");
+        auto &continuator = self.attach(process);
+        for (sol::table child_process : va) {
+          continuator.then(std::move(child_process));
+        }
+      },
+    "update",
+      [](wheel_scheduler &self, fsec dt, void *data) {
+        PROFILER_ZONE("wheel_scheduler", "update");
+        self.update(dt, data);
+      },
+    "abort",
+      sol::overload(
+        [](wheel_scheduler &self) {
+          PROFILER_ZONE("wheel_scheduler", "abort");
+          self.abort();
+        },
+        [](wheel_scheduler &self, bool immediately) {
+          PROFILER_ZONE("wheel_scheduler", "abort");
+          self.abort(immediately);
+        }
+      )
+  );
+
+  // Same interface as above, native processes (attached in c++) are
+  // updated in parallel
+  entt_module.new_usertype<parallel_scheduler>("parallel_scheduler",
+    sol::meta_function::construct,
+    sol::factories([]{ return parallel_scheduler{}; }),
+
+    "size", &parallel_scheduler::size,
+    "empty", &parallel_scheduler::empty,
+    "clear",
+      [](parallel_scheduler &self) {
+        PROFILER_ZONE("parallel_scheduler", "clear");
+        self.clear();
+      },
+    "attach",
+      [](parallel_scheduler &self, const sol::object &process,
+         const sol::variadic_args &va) {
+        PROFILER_ZONE("parallel_scheduler", "attach");
+        attach_script_processes(self, process, va);
+      },
+    // Profiled by parallel_scheduler::update itself
+    "update", &parallel_scheduler::update,
+    "abort",
+      sol::overload(
+        [](parallel_scheduler &self) {
+          PROFILER_ZONE("parallel_scheduler", "abort");
+          self.abort();
+        },
+        [](parallel_scheduler &self, bool immediately) {
+          PROFILER_ZONE("parallel_scheduler", "abort");
+          self.abort(immediately);
+        }
+      )
+  );
+
+  // Wake conditions of coroutine processes, in lua:
+  // coroutine.yield(entt.wait(2))
+  entt_module.set_function("wait", [](float seconds) { return seconds; });
+  entt_module.set_function("next_frame", [] {});
+  // Signals are raised only by entt.notify, they're not connected to the
+  // dispatcher (a triggered/enqueued event doesn't wake anyone). Parked
+  // coroutines are still ticked every frame (no calls into lua), and
+  // wheel_scheduler can't host coroutine processes.
+  entt_module.set_function("wait_signal", [](const sol::object &key) {
+    return wake_signal{to_signal_key(key)};
+  });
+  // Wakes coroutines waiting for a signal, returns how many
+  entt_module.set_function("notify",
+    [](const sol::object &key, const sol::object &payload, sol::this_state s) {
+      PROFILER_ZONE("scheduler", "notify");
+      return signal_waiters::get(s).notify(to_signal_key(key), payload);
+    });
+  // clang-format on
+
+  return entt_module;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "entt/container/dense_map.hpp"
+#include "entt/core/hashed_string.hpp"
+#include "entt/process/process.hpp"
+#include "meta_helper.hpp"
+#include "script_process.hpp"
+
+// Value yielded by wait_signal, in lua: coroutine.yield(entt.wait_signal(Foo))
+struct wake_signal {
+  entt::id_type signal;
+};
+
+// Key of a signal a coroutine waits for: a type (with type_id), its id or
+// a name (hashed)
+[[nodiscard]] inline entt::id_type to_signal_key(const sol::object &key) {
+  if (key.get_type() == sol::type::string)
+    return entt::hashed_string::value(key.as<const char *>());
+  return deduce_type(key);
+}
+
+// Coroutines parked on signals, one per lua state, woken by entt.notify
+class signal_waiters {
+public:
+  struct waiter {
+    bool fired{false};
+    sol::object payload;
+  };
+
+  [[nodiscard]] static signal_waiters &get(lua_State *L) {
+    static const char key{};
+    lua_rawgetp(L, LUA_REGISTRYINDEX, &key);
+    if (lua_type(L, -1) != LUA_TUSERDATA) {
+      lua_pop(L, 1);
+      sol::stack::push(L, signal_waiters{});
+      lua_pushvalue(L, -1);
+      lua_rawsetp(L, LUA_REGISTRYINDEX, &key);
+    }
+    auto &self = sol::stack::get<signal_waiters &>(L, -1);
+    lua_pop(L, 1);
+    return self;
+  }
+
+  [[nodiscard]] std::shared_ptr<waiter> park(entt::id_type signal) {
+    auto &waiters = m_waiters[signal];
+    // Processes gone (aborted, cleared) while parked
+    waiters.erase(std::remove_if(waiters.begin(), waiters.end(),
+                                 [](const auto &w) { return w.expired(); }),
+                  waiters.end());
+    auto w = std::make_shared<waiter>();
+    waiters.push_back(w);
+    return w;
+  }
+  // Wakes all coroutines waiting for a signal (on their next tick), the
+  // payload is the result of their yield
+  std::size_t notify(entt::id_type signal, const sol::object &payload) {
+    const auto it = m_waiters.find(signal);
+    if (it == m_waiters.end()) return 0;
+
+    std::size_t count{0};
+    for (const auto &weak : it->second) {
+      if (auto w = weak.lock(); w) {
+        w->fired = true;
+        w->payload = payload;
+        ++count;
+      }
+    }
+    it->second.clear();
+    return count;
+  }
+
+private:
+  entt::dense_map<entt::id_type, std::vector<std::weak_ptr<waiter>>>
+    m_waiters;
+};
+
+// Process defined by a lua function, run as a coroutine: f(self)
+// The function yields what it waits for:
+//  - nothing (entt.next_frame()) - resumed on the next tick
+//  - seconds (entt.wait(2))      - resumed when the time is up
+//  - entt.wait_signal(Foo)       - resumed (with the payload) after
+//                                  entt.notify(Foo, payload)
+// A parked coroutine is not resumed (no calls into lua) until then, but it's
+// still ticked by the scheduler (a flag check).
+// Returning from the function succeeds the process, an error fails it.
+// self has the same controls as in script_process (succeed, fail ...),
+// hooks (succeeded, failed, aborted) are set with self.set_hook.
+class coroutine_process : public entt::process<coroutine_process, fsec> {
+  enum class wait_for : std::uint8_t { next_frame, time, signal };
+
+public:
+  explicit coroutine_process(const sol::function &f)
+      : m_thread{sol::thread::create(f.lua_state())},
+        m_coroutine{m_thread.state(), f},
+        m_binding{sol::state_view{f.lua_state()}.create_table()} {
+    auto &self = m_binding.self();
+#define BIND(func) self.set_function(#func, &coroutine_process::func, this)
+
+    BIND(succeed);
+    BIND(fail);
+    BIND(pause);
+    BIND(unpause);
+
+    BIND(abort);
+    BIND(alive);
+    BIND(finished);
+    BIND(paused);
+    BIND(rejected);
+
+#undef BIND
+  }
+  ~coroutine_process() {
+    std::cout << "coroutine_process: " << m_binding.self().pointer()
+              << " terminated" << std::endl;
+    m_binding.self().clear();
+    m_binding.abandon();
+  }
+
+  void update(fsec dt, void *) {
+    switch (m_wait) {
+    case wait_for::next_frame:
+      break;
+    case wait_for::time:
+      m_remaining -= dt;
+      if (m_remaining > fsec{0}) return;
+      break;
+    case wait_for::signal:
+      if (!m_signal->fired) return;
+      break;
+    }
+    _resume();
+  }
+  void succeeded() { m_binding.call(script_hook::succeeded); }
+  void failed() { m_binding.call(script_hook::failed); }
+  void aborted() { m_binding.call(script_hook::aborted); }
+
+private:
+  void _resume() {
+    PROFILER_ZONE("coroutine", "resume");
+    auto result = [this] {
+      if (!m_started) {
+        m_started = true;
+        return m_coroutine(m_binding.self());
+      }
+      if (m_signal) return m_coroutine(std::move(m_signal->payload));
+      return m_coroutine();
+    }();
+    m_wait = wait_for::next_frame;
+    m_signal.reset();
+
+    if (!result.valid()) {
+      const sol::error err = result;
+      std::cout << "coroutine_process: " << err.what() << std::endl;
+      return fail();
+    }
+    if (result.status() != sol::call_status::yielded) return succeed();
+
+    if (result.return_count() == 0) return;
+    if (const sol::object value = result; value.is<wake_signal>()) {
+      m_signal = signal_waiters::get(m_thread.state())
+                  .park(value.as<wake_signal>().signal);
+      m_wait = wait_for::signal;
+    } else if (value.get_type() == sol::type::number) {
+      m_remaining = fsec{value.as<float>()};
+      m_wait = wait_for::time;
+    }
+  }
+
+private:
+  sol::thread m_thread;
+  sol::coroutine m_coroutine;
+  script_binding m_binding;
+
+  bool m_started{false};
+  wait_for m_wait{wait_for::next_frame};
+  fsec m_remaining{0};
+  std::shared_ptr<signal_waiters::waiter> m_signal;
+};
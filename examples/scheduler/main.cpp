@@ -1,55 +1,23 @@
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
 #include <thread>
 #include "../common/kbhit.hpp"
 
-#include "script_process.hpp"
-#include "entt/process/scheduler.hpp"
+#include "gc_controller.hpp"
+#include "script_pack.hpp"
+#include "bond.hpp"
 
 #define AUTO_ARG(x) decltype(x), x
 
 namespace {
 
-using scheduler = entt::basic_scheduler<fsec>;
-
-[[nodiscard]] sol::table open_scheduler(sol::this_state s) {
-  // To create a scheduler inside a script: entt.scheduler.new()
-
-  sol::state_view lua{s};
-  auto entt_module = lua["entt"].get_or_create<sol::table>();
-
-  // clang-format off
-  entt_module.new_usertype<scheduler>("scheduler",
-    sol::meta_function::construct,
-    sol::factories([]{ return scheduler{}; }),
-
-    "size", &scheduler::size,
-    "empty", &scheduler::empty,
-    "clear", &scheduler::clear,
-    "attach",
-      [](scheduler &self, const sol::table &process,
-         const sol::variadic_args &va) {
-        // TODO: validate process before attach?
-        auto &continuator = self.template attach<script_process>(process);
-        for (sol::table child_process : va) {
-          continuator.template then<script_process>(std::move(child_process));
-        }
-      },
-    "update", sol::resolve<void(fsec, void *)>(&scheduler::update),
-    "abort",
-      sol::overload(
-        [](scheduler &self) { self.abort(); },
-        sol::resolve<void(bool)>(&scheduler::abort)
-      )
-  );
-  // clang-format on
-
-  return entt_module;
-}
-
 #if 0
 // Few ways to 'require' a module from a script:
 // 1. extend package.path
 // 2. lua.require_file("test_process", "lua/test_process.lua");
 // 3. lua.add_package_loader(lua_custom_require);
+// 4. script_pack::add_package_loader (precompiled scripts, used below)
 
 #include <filesystem>
 #include <fstream>
@@ -80,6 +48,27 @@ void extend_path(sol::state &lua) {
 }
 #endif
 
+// CPU-bound native process (e.g. path finding), ticked on any thread of
+// parallel_scheduler
+class native_process : public entt::process<native_process, fsec> {
+public:
+  explicit native_process(std::size_t num_frames) : m_num_frames{num_frames} {}
+
+  void update(fsec, void *) {
+    for (auto i = 0; i < 100'000; ++i)
+      m_state = m_state * 1664525u + 1013904223u;
+    if (++m_frame == m_num_frames) succeed();
+  }
+  void succeeded() {
+    std::cout << "native_process: " << m_state << " succeeded" << std::endl;
+  }
+
+private:
+  const std::size_t m_num_frames;
+  std::size_t m_frame{0};
+  std::uint32_t m_state{1};
+};
+
 } // namespace
 
 int main(int argc, char *argv[]) {
@@ -90,34 +79,67 @@ int main(int argc, char *argv[]) {
 #endif
 
   try {
+    // Bytecode of all scripts, built with PRECOMPILE_SCRIPTS
+    // (without the pack, scripts are loaded from source files)
+    script_pack pack{"lua.pack"};
+
     sol::state lua{};
     lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::string);
     lua.require("scheduler", sol::c_call<AUTO_ARG(&open_scheduler)>, false);
-
-    scheduler scheduler{};
-    lua["scheduler"] =
-      std::ref(scheduler); // Make the scheduler available to Lua
-
-    lua.do_file("lua/process_chain.lua");
-
-    using namespace std::chrono_literals;
-
-    constexpr auto target_frame_time = 16ms;
-    fsec delta_time{target_frame_time};
-
-    while (!scheduler.empty()) {
-      using clock = std::chrono::high_resolution_clock;
-      const auto begin_ticks = clock::now();
-
-      lua.step_gc(4);
-
-      scheduler.update(delta_time);
-      std::this_thread::sleep_for(target_frame_time);
-
-      delta_time = std::chrono::duration_cast<fsec>(clock::now() - begin_ticks);
-      if (delta_time > 1s) delta_time = target_frame_time;
-
-      if (_kbhit()) break;
+    lua.require("profiler", sol::c_call<AUTO_ARG(&open_profiler)>, false);
+    pack.add_package_loader(lua);
+
+    // Run with "wheel" argument to use wheel_scheduler (timer wheel)
+    // or "parallel" to use parallel_scheduler
+    const std::string_view mode{argc > 1 ? argv[1] : ""};
+
+    // Steps the collector within time left in a frame
+    gc_controller gc{lua};
+
+    const auto run = [&lua, &pack, &gc](auto &scheduler,
+                                        std::initializer_list<const char *>
+                                          scripts) {
+      lua["scheduler"] =
+        std::ref(scheduler); // Make the scheduler available to Lua
+
+      for (const auto *script : scripts)
+        pack.script_file(lua, script);
+
+      using namespace std::chrono_literals;
+
+      constexpr auto target_frame_time = 16ms;
+      fsec delta_time{target_frame_time};
+
+      while (!scheduler.empty()) {
+        using clock = gc_controller::clock;
+        const auto begin_ticks = clock::now();
+
+        scheduler.update(delta_time);
+        gc.step_until(begin_ticks + target_frame_time);
+        profiler::get().frame();
+        std::this_thread::sleep_for(target_frame_time);
+
+        delta_time =
+          std::chrono::duration_cast<fsec>(clock::now() - begin_ticks);
+        if (delta_time > 1s) delta_time = target_frame_time;
+
+        if (_kbhit()) break;
+      }
+    };
+    if (mode == "wheel") {
+      wheel_scheduler scheduler{};
+      run(scheduler, {"lua/process_chain.lua"});
+    } else if (mode == "parallel") {
+      parallel_scheduler scheduler{};
+      // Chains of native processes, next to scripted ones
+      for (auto i = 0; i < 16; ++i) {
+        scheduler.attach<native_process>(60).then<native_process>(30);
+      }
+      run(scheduler, {"lua/process_chain.lua", "lua/coroutine_process.lua"});
+    } else {
+      // Coroutine processes are supported only by entt::scheduler
+      scheduler scheduler{};
+      run(scheduler, {"lua/process_chain.lua", "lua/coroutine_process.lua"});
     }
   } catch (const std::exception &e) {
     std::cout << "exception: " << e.what();
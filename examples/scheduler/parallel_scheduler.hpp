@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "profiler.hpp"
+#include "work_stealing_pool.hpp"
+#include "coroutine_process.hpp"
+
+// Processes bound to a lua_State, run only on the thread calling update
+template <typename Proc> struct is_pinned_process : std::false_type {};
+template <> struct is_pinned_process<script_process> : std::true_type {};
+template <> struct is_pinned_process<coroutine_process> : std::true_type {};
+
+// Scheduler that ticks native processes in parallel (work_stealing_pool),
+// while pinned (script) processes are ticked by the calling thread.
+// Native processes must not depend on each other (within a frame), nor
+// touch a lua_State. A chain is ticked one process at a time, the next one
+// starts on the update after its predecessor succeeded.
+// Differences from entt::scheduler:
+//  - processes attached during update are ticked from the next update
+//  - clear and abort called by a script process (during update) are
+//    deferred until all processes of the frame are ticked
+class parallel_scheduler {
+  struct basic_task {
+    virtual ~basic_task() = default;
+
+    virtual void tick(fsec dt) = 0;
+    virtual void abort(bool immediately) = 0;
+    [[nodiscard]] virtual bool finished() const = 0;
+    [[nodiscard]] virtual bool rejected() const = 0;
+  };
+  template <typename Proc> struct typed_task final : basic_task {
+    template <typename... Args>
+    explicit typed_task(Args &&...args)
+        : process{std::forward<Args>(args)...} {}
+
+    void tick(fsec dt) override { process.tick(dt); }
+    void abort(bool immediately) override { process.abort(immediately); }
+    [[nodiscard]] bool finished() const override { return process.finished(); }
+    [[nodiscard]] bool rejected() const override { return process.rejected(); }
+
+    Proc process;
+  };
+
+  struct handler {
+    std::unique_ptr<basic_task> task;
+    std::unique_ptr<handler> next;
+    bool pinned;
+  };
+  using handler_ptr = std::unique_ptr<handler>;
+
+public:
+  explicit parallel_scheduler(
+    std::size_t num_threads = work_stealing_pool::default_concurrency())
+      : m_pool{std::make_unique<work_stealing_pool>(num_threads)} {}
+  parallel_scheduler(const parallel_scheduler &) = delete;
+  parallel_scheduler(parallel_scheduler &&) noexcept = default;
+
+  parallel_scheduler &operator=(const parallel_scheduler &) = delete;
+  parallel_scheduler &operator=(parallel_scheduler &&) noexcept = default;
+
+  [[nodiscard]] std::size_t size() const {
+    return m_pinned.size() + m_native.size() + m_attached.size();
+  }
+  [[nodiscard]] bool empty() const { return size() == 0; }
+  void clear() {
+    if (m_updating) {
+      m_pending_clear = true;
+      return;
+    }
+    m_pinned.clear();
+    m_native.clear();
+    m_attached.clear();
+    m_last = nullptr;
+  }
+
+  template <typename Proc, typename... Args>
+  parallel_scheduler &attach(Args &&...args) {
+    auto h = _make_handler<Proc>(std::forward<Args>(args)...);
+    m_last = h.get();
+    m_attached.push_back(std::move(h));
+    return *this;
+  }
+  // Appends a process to the chain of the last attached one
+  template <typename Proc, typename... Args>
+  parallel_scheduler &then(Args &&...args) {
+    assert(m_last && "Process not available");
+    auto *curr = m_last;
+    while (curr->next)
+      curr = curr->next.get();
+    curr->next = _make_handler<Proc>(std::forward<Args>(args)...);
+    return *this;
+  }
+
+  void update(fsec dt, void * = nullptr) {
+    PROFILER_ZONE("parallel_scheduler", "update");
+    for (auto &h : std::exchange(m_attached, {}))
+      _insert(std::move(h));
+
+    m_updating = true;
+    try {
+      m_pool->run(
+        m_native.size(),
+        [this, dt](std::size_t i) { m_native[i]->task->tick(dt); },
+        [this, dt] {
+          for (auto &h : m_pinned)
+            h->task->tick(dt);
+        });
+    } catch (...) {
+      m_updating = false;
+      m_pending_clear = false;
+      m_pending_abort.reset();
+      throw;
+    }
+    m_updating = false;
+    _advance(m_pinned);
+    _advance(m_native);
+
+    if (std::exchange(m_pending_clear, false)) {
+      m_pending_abort.reset();
+      clear();
+    } else if (const auto immediately = std::exchange(m_pending_abort, {});
+               immediately) {
+      abort(*immediately);
+    }
+  }
+
+  void abort(bool immediately = false) {
+    if (m_updating) {
+      m_pending_abort = m_pending_abort.value_or(false) || immediately;
+      return;
+    }
+    for (auto &h : std::exchange(m_attached, {}))
+      _insert(std::move(h));
+    m_last = nullptr;
+    for (auto *handlers : {&m_pinned, &m_native}) {
+      for (auto &h : *handlers)
+        h->task->abort(immediately);
+    }
+    if (immediately) {
+      _advance(m_pinned);
+      _advance(m_native);
+    }
+  }
+
+private:
+  template <typename Proc, typename... Args>
+  [[nodiscard]] static handler_ptr _make_handler(Args &&...args) {
+    auto h = std::make_unique<handler>();
+    h->task = std::make_unique<typed_task<Proc>>(std::forward<Args>(args)...);
+    h->pinned = is_pinned_process<Proc>::value;
+    return h;
+  }
+
+  void _insert(handler_ptr h) {
+    (h->pinned ? m_pinned : m_native).push_back(std::move(h));
+  }
+
+  // Serially, after all processes of a frame are ticked
+  void _advance(std::vector<handler_ptr> &handlers) {
+    for (std::size_t i = 0; i < handlers.size();) {
+      auto &h = handlers[i];
+      const auto done = h->task->finished() || h->task->rejected();
+      if (!done) {
+        ++i;
+        continue;
+      }
+      // Dead chain, can't be continued with then()
+      if (m_last == h.get()) m_last = nullptr;
+
+      auto next = h->task->finished() ? std::move(h->next) : nullptr;
+      std::swap(h, handlers.back());
+      handlers.pop_back();
+      // Starts on the next update
+      if (next) m_attached.push_back(std::move(next));
+    }
+  }
+
+private:
+  std::unique_ptr<work_stealing_pool> m_pool;
+  std::vector<handler_ptr> m_pinned;
+  std::vector<handler_ptr> m_native;
+  // Not ticked yet (attached or continued), see update
+  std::vector<handler_ptr> m_attached;
+  handler *m_last{nullptr};
+  bool m_updating{false};
+  // Requested during update
+  bool m_pending_clear{false};
+  std::optional<bool> m_pending_abort;
+};
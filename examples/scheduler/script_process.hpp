@@ -2,7 +2,7 @@
 
 #include <chrono>
 #include "entt/process/process.hpp"
-#include "sol/sol.hpp"
+#include "script_binding.hpp"
 
 using fsec = std::chrono::duration<float>;
 
@@ -10,8 +10,9 @@ class script_process : public entt::process<script_process, fsec> {
 public:
   script_process(const sol::table &t,
                  const fsec freq = std::chrono::milliseconds{250})
-      : m_self{t}, m_update{m_self["update"]}, m_frequency{freq} {
-#define BIND(func) m_self.set_function(#func, &script_process::func, this)
+      : m_binding{t}, m_frequency{freq} {
+    auto &self = m_binding.self();
+#define BIND(func) self.set_function(#func, &script_process::func, this)
 
     BIND(succeed);
     BIND(fail);
@@ -27,39 +28,35 @@ public:
 #undef BIND
   }
   ~script_process() {
-    std::cout << "script_process: " << m_self.pointer() << " terminated"
-              << std::endl;
-    m_self.clear();
-    m_self.abandon();
+    std::cout << "script_process: " << m_binding.self().pointer()
+              << " terminated" << std::endl;
+    m_binding.self().clear();
+    m_binding.abandon();
   }
 
   void init() {
-    std::cout << "script_process: " << m_self.pointer() << " joined"
+    std::cout << "script_process: " << m_binding.self().pointer() << " joined"
               << std::endl;
-    _call("init");
+    m_binding.call(script_hook::init);
   }
 
   void update(fsec dt, void *) {
-    if (!m_update.valid()) return fail();
+    if (!m_binding.has(script_hook::update)) return fail();
 
     m_time += dt;
     if (m_time >= m_frequency) {
-      m_update(m_self, dt.count());
+      m_binding.call(script_hook::update, dt.count());
       m_time = fsec{0};
     }
   }
-  void succeeded() { _call("succeeded"); }
-  void failed() { _call("failed"); }
-  void aborted() { _call("aborted"); }
+  void succeeded() { m_binding.call(script_hook::succeeded); }
+  void failed() { m_binding.call(script_hook::failed); }
+  void aborted() { m_binding.call(script_hook::aborted); }
 
-private:
-  void _call(const std::string_view function_name) {
-    if (auto &&f = m_self[function_name]; f.valid()) f(m_self);
-  }
+  [[nodiscard]] fsec frequency() const { return m_frequency; }
 
 private:
-  sol::table m_self;
-  sol::function m_update;
+  script_binding m_binding;
 
   fsec m_frequency;
   fsec m_time{0};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include "timer_wheel.hpp"
+#include "script_process.hpp"
+
+// Scheduler of script processes, backed by a timer wheel.
+// A process is ticked only when its update is due (every 'frequency'), so
+// idle processes cost nothing per frame.
+// Differences from entt::scheduler:
+//  - paused process is polled (and skipped) once per 'frequency'
+//  - abort(false) is handled at the next update (not when process is due)
+class wheel_scheduler {
+  struct handler {
+    std::unique_ptr<script_process> process;
+    std::unique_ptr<handler> next;
+    fsec last_tick{0};
+  };
+  using handler_ptr = std::unique_ptr<handler>;
+
+public:
+  explicit wheel_scheduler(fsec resolution = std::chrono::milliseconds{1})
+      : m_wheel{resolution} {}
+  wheel_scheduler(const wheel_scheduler &) = delete;
+  wheel_scheduler(wheel_scheduler &&) noexcept = default;
+
+  wheel_scheduler &operator=(const wheel_scheduler &) = delete;
+  wheel_scheduler &operator=(wheel_scheduler &&) noexcept = default;
+
+  [[nodiscard]] std::size_t size() const { return m_wheel.size(); }
+  [[nodiscard]] bool empty() const { return m_wheel.empty(); }
+  void clear() {
+    m_wheel.clear();
+    m_last = nullptr;
+  }
+
+  template <typename... Args> wheel_scheduler &attach(Args &&...args) {
+    auto h = _make_handler(std::forward<Args>(args)...);
+    m_last = h.get();
+    // init on the next tick
+    m_wheel.schedule(std::move(h), fsec{0});
+    return *this;
+  }
+  // Appends a process to the chain of the last attached one
+  template <typename... Args> wheel_scheduler &then(Args &&...args) {
+    assert(m_last && "Process not available");
+    auto *curr = m_last;
+    while (curr->next)
+      curr = curr->next.get();
+    curr->next = _make_handler(std::forward<Args>(args)...);
+    return *this;
+  }
+
+  void update(fsec dt, void * = nullptr) {
+    m_wheel.advance(dt, [this](handler_ptr &&h) { _tick(std::move(h)); });
+  }
+
+  void abort(bool immediately = false) {
+    std::vector<handler_ptr> handlers;
+    handlers.reserve(m_wheel.size());
+    m_wheel.drain([&handlers](handler_ptr &&h) {
+      handlers.push_back(std::move(h));
+    });
+    m_last = nullptr;
+    for (auto &h : handlers) {
+      h->process->abort(immediately);
+      if (!immediately) m_wheel.schedule(std::move(h), fsec{0});
+    }
+  }
+
+private:
+  template <typename... Args>
+  [[nodiscard]] static handler_ptr _make_handler(Args &&...args) {
+    auto h = std::make_unique<handler>();
+    h->process = std::make_unique<script_process>(std::forward<Args>(args)...);
+    return h;
+  }
+
+  void _tick(handler_ptr h) {
+    auto &process = *h->process;
+    const auto now = m_wheel.now();
+    // Rounding to the wheel resolution might yield slightly less than
+    // 'frequency', which would make the process skip its update.
+    const auto elapsed = std::max(now - h->last_tick, process.frequency());
+    h->last_tick = now;
+    process.tick(elapsed);
+
+    if (process.finished()) {
+      if (auto next = std::move(h->next); next) {
+        next->last_tick = now;
+        m_wheel.schedule(std::move(next), fsec{0});
+      }
+    } else if (!process.rejected()) {
+      m_wheel.schedule(std::move(h), process.frequency());
+    }
+    // Dead chain, can't be continued with then()
+    if (h && m_last == h.get()) m_last = nullptr;
+  }
+
+private:
+  timer_wheel<handler_ptr> m_wheel;
+  handler *m_last{nullptr};
+};
@@ -1,9 +1,12 @@
 #include <thread>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include "../common/kbhit.hpp"
 
 #include "../registry/bond.hpp"
 #include "../common/transform.hpp"
+#include "script_workers.hpp"
 
 #define AUTO_ARG(x) decltype(x), x
 
@@ -11,44 +14,56 @@ using fsec = std::chrono::duration<float>;
 
 namespace {
 
-struct ScriptComponent {
-  sol::table self;
-  struct {
-    sol::function update;
-  } hooks;
-};
-
 void inspect_script(const ScriptComponent &script) {
-  script.self.for_each([](const sol::object &key, const sol::object &value) {
+  script.binding.self().for_each([](const sol::object &key, const sol::object &value) {
     std::cout << key.as<std::string>() << ": "
               << sol::type_name(value.lua_state(), value.get_type())
               << std::endl;
   });
 }
 
-void init_script(entt::registry &registry, entt::entity entity) {
+void bind_script(entt::registry &registry, entt::entity entity) {
   auto &script = registry.get<ScriptComponent>(entity);
-  assert(script.self.valid());
-  script.hooks.update = script.self["update"];
-  assert(script.hooks.update.valid());
-
-  script.self["id"] = sol::readonly_property([entity] { return entity; });
-  script.self["owner"] = std::ref(registry);
-  if (auto &&f = script.self["init"]; f.valid()) f(script.self);
-  // inspect_script(script);
+  assert(script.binding.valid());
+
+  auto &self = script.binding.self();
+  self["id"] = sol::readonly_property([entity] { return entity; });
+  self["owner"] = std::ref(registry);
+}
+void init_script(entt::registry &registry, entt::entity entity) {
+  bind_script(registry, entity);
+  registry.get<ScriptComponent>(entity).binding.call(script_hook::init);
+  // inspect_script(registry.get<ScriptComponent>(entity));
+}
+
+// Restored scripts are bound to their entities, but not initialized again
+// (their data is already there)
+bool restore_world(entt::registry &registry, const char *path,
+                   lua_State *L) {
+  registry.on_construct<ScriptComponent>().disconnect<&init_script>();
+  const auto restored = load_snapshot(registry, path, L);
+  registry.on_construct<ScriptComponent>().connect<&init_script>();
+  if (!restored) {
+    // Might be partially loaded
+    registry.clear();
+    return false;
+  }
+  for (auto entity : registry.view<ScriptComponent>())
+    bind_script(registry, entity);
+  return true;
 }
 void release_script(entt::registry &registry, entt::entity entity) {
   auto &script = registry.get<ScriptComponent>(entity);
-  if (auto &&f = script.self["destroy"]; f.valid()) f(script.self);
-  script.self.abandon();
+  script.binding.call(script_hook::destroy);
+  script.binding.abandon();
 }
 
 void script_system_update(entt::registry &registry, fsec delta_time) {
   auto view = registry.view<ScriptComponent>();
   for (auto entity : view) {
     auto &script = view.get<ScriptComponent>(entity);
-    assert(script.self.valid());
-    script.hooks.update(script.self, delta_time);
+    assert(script.binding.valid());
+    script.binding.call(script_hook::update, delta_time);
   }
 }
 
@@ -61,37 +76,85 @@ int main(int argc, char *argv[]) {
   _CrtSetReportFile(_CRT_ASSERT, _CRTDBG_FILE_STDERR);
 #endif
 
+  // Usage: system [num_workers] [--snapshot path]
+  //  num_workers = 0: scripts are updated on main thread
+  //  --snapshot: continues from a snapshot (if any) and saves it on exit,
+  //              single state mode only
+  unsigned long num_workers{0};
+  const char *snapshot_path{nullptr};
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+      snapshot_path = argv[++i];
+    } else {
+      num_workers = std::strtoul(argv[i], nullptr, 10);
+    }
+  }
+
   try {
     register_meta_component<Transform>();
+    register_meta_snapshot<ScriptComponent>();
 
     entt::registry registry{};
     registry.on_construct<ScriptComponent>().connect<&init_script>();
     registry.on_destroy<ScriptComponent>().connect<&release_script>();
 
+    const auto setup = [](sol::state &lua) -> sol::function {
+      lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::string);
+      lua.require("registry", sol::c_call<AUTO_ARG(&open_registry)>, false);
+      lua.require("profiler", sol::c_call<AUTO_ARG(&open_profiler)>, false);
+      register_transform(lua); // Make Transform struct available to Lua
+
+      auto behavior_script = lua.load_file("lua/behavior_script.lua");
+      assert(behavior_script.valid());
+      return behavior_script;
+    };
+
     sol::state lua{};
-    lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::string);
-    lua.require("registry", sol::c_call<AUTO_ARG(&open_registry)>, false);
-    register_transform(lua); // Make Transform struct available to Lua
+    const auto behavior_script = setup(lua);
+    // Single state mode, structural changes are applied immediately
+    lua.script("function defer(f) f() end");
+
+    // Steps the collector within time left in a frame
+    gc_controller gc{lua};
 
-    auto behavior_script = lua.load_file("lua/behavior_script.lua");
-    assert(behavior_script.valid());
+    std::unique_ptr<script_workers> workers;
+    if (num_workers > 0) {
+      workers = std::make_unique<script_workers>(registry, num_workers, setup);
+    }
 
-    for (int i = 0; i < 5; ++i) {
-      auto e = registry.create();
-      registry.emplace<Transform>(e, Transform{i, i});
-      registry.emplace<ScriptComponent>(e, behavior_script.call());
+    if (workers) snapshot_path = nullptr;
+    registry.ctx().emplace<script_factory>(behavior_script);
+    if (!snapshot_path || !restore_world(registry, snapshot_path, lua)) {
+      for (int i = 0; i < 5; ++i) {
+        auto e = registry.create();
+        registry.emplace<Transform>(e, Transform{i, i});
+        if (workers) {
+          workers->emplace(e);
+        } else {
+          registry.emplace<ScriptComponent>(
+            e, script_binding{behavior_script.call<sol::table>()});
+        }
+      }
     }
 
     using namespace std::chrono_literals;
 
     constexpr auto target_frame_time = 500ms;
+    constexpr auto frame_budget = 16ms; // The rest of a frame is idle
     fsec delta_time{target_frame_time};
 
     while (true) {
-      using clock = std::chrono::high_resolution_clock;
+      using clock = gc_controller::clock;
       const auto begin_ticks = clock::now();
-
-      script_system_update(registry, delta_time);
+      const auto gc_deadline = begin_ticks + frame_budget;
+
+      if (workers) {
+        workers->update(delta_time, gc_deadline);
+      } else {
+        script_system_update(registry, delta_time);
+      }
+      gc.step_until(gc_deadline);
+      profiler::get().frame();
       std::this_thread::sleep_for(target_frame_time);
 
       delta_time = std::chrono::duration_cast<fsec>(clock::now() - begin_ticks);
@@ -99,7 +162,10 @@ int main(int argc, char *argv[]) {
 
       if (_kbhit()) break;
     }
+    if (snapshot_path) save_snapshot(registry, snapshot_path);
+    workers.reset();
     registry.clear();
+    registry.ctx().erase<script_factory>();
   } catch (const std::exception &e) {
     std::cout << "exception: " << e.what();
     return -1;
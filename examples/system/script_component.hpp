@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../registry/snapshot.hpp"
+#include "script_binding.hpp"
+
+struct ScriptComponent {
+  script_binding binding; // self and its (pre-resolved) hooks
+  // Index of a script_worker (owner of 'self'), used only in parallel mode
+  std::size_t worker{0};
+};
+
+// Creates 'self' of scripts restored from a snapshot (in the registry
+// context), e.g. registry.ctx().emplace<script_factory>(behavior_script)
+struct script_factory {
+  sol::function create;
+};
+
+// Only the data portion of 'self' is saved (no functions and userdata),
+// a restored script is a new instance (script_factory) with that data.
+// Scripts are restored into the state of the reader (single state mode).
+template <> struct component_serializer<ScriptComponent> {
+  static void save(snapshot_writer &writer, const ScriptComponent &script) {
+    const auto &self = script.binding.self();
+    lua_State *L = self.lua_state();
+    self.push();
+    writer.write_value(L, -1);
+    lua_pop(L, 1);
+  }
+  static void load(snapshot_reader &reader, ScriptComponent &script) {
+    lua_State *L = reader.lua_state();
+    reader.read_value(L);
+    const sol::object data{L, -1};
+    lua_pop(L, 1);
+
+    const auto *factory = reader.registry().ctx().find<script_factory>();
+    auto self = factory && factory->create.valid()
+                  ? factory->create.call<sol::table>()
+                  : sol::state_view{L}.create_table();
+    if (data.get_type() == sol::type::table) {
+      data.as<sol::table>().for_each(
+        [&self](const sol::object &key, const sol::object &value) {
+          self.raw_set(key, value);
+        });
+    }
+    script.binding = script_binding{std::move(self)};
+  }
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "entt/entity/registry.hpp"
+#include "../registry/deferred_patch.hpp"
+#include "gc_controller.hpp"
+#include "script_component.hpp"
+
+// Runs update hooks of ScriptComponents on N threads, each thread owns a
+// lua_State (entities are sharded between them).
+// While workers are running, scripts may read any component and modify
+// components of their own entity. Structural changes (create, destroy,
+// emplace, remove) must be wrapped in defer(function() ... end), deferred
+// functions are called on the main thread once all workers are done.
+// registry:get doesn't emplace a missing component there, it returns nil,
+// structural bindings called directly raise a lua error.
+// Writes through proxies don't emit on_update right away, patches are
+// replayed on the main thread (before deferred functions).
+class script_workers {
+  using fsec = std::chrono::duration<float>;
+
+public:
+  // Initializes a worker state (libraries, bindings), returns a factory of
+  // script instances (e.g. result of load_file).
+  using setup_fn = std::function<sol::function(sol::state &)>;
+
+  script_workers(entt::registry &registry, std::size_t num_workers,
+                 const setup_fn &setup)
+      : m_registry{registry} {
+    assert(num_workers > 0);
+    m_workers.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+      auto &worker = *m_workers.emplace_back(std::make_unique<script_worker>());
+      worker.factory = setup(worker.lua);
+      worker.lua["defer"] = [&worker](const sol::function &f) {
+        worker.deferred.push_back(f);
+      };
+    }
+
+    registry.on_construct<ScriptComponent>()
+      .connect<&script_workers::_on_construct>(*this);
+    registry.on_destroy<ScriptComponent>()
+      .connect<&script_workers::_on_destroy>(*this);
+
+    for (std::size_t i = 0; i < num_workers; ++i)
+      m_threads.emplace_back(&script_workers::_run, this, i);
+  }
+  script_workers(const script_workers &) = delete;
+  ~script_workers() {
+    {
+      std::lock_guard lock{m_mutex};
+      m_stop = true;
+    }
+    m_start.notify_all();
+    for (auto &thread : m_threads)
+      thread.join();
+
+    // Scripts can't outlive states of workers
+    m_registry.clear<ScriptComponent>();
+
+    m_registry.on_construct<ScriptComponent>()
+      .disconnect<&script_workers::_on_construct>(*this);
+    m_registry.on_destroy<ScriptComponent>()
+      .disconnect<&script_workers::_on_destroy>(*this);
+  }
+
+  script_workers &operator=(const script_workers &) = delete;
+
+  [[nodiscard]] std::size_t size() const { return m_workers.size(); }
+
+  // Creates ScriptComponent for a given entity in the least loaded worker.
+  ScriptComponent &emplace(entt::entity entity) {
+    std::size_t index{0};
+    for (std::size_t i = 1; i < m_workers.size(); ++i) {
+      if (m_workers[i]->shard.size() < m_workers[index]->shard.size())
+        index = i;
+    }
+    auto &worker = *m_workers[index];
+    return m_registry.emplace<ScriptComponent>(
+      entity,
+      ScriptComponent{script_binding{worker.factory.call<sol::table>()}, index});
+  }
+
+  // Workers step their collectors until gc_deadline (after updates)
+  void update(fsec delta_time, gc_controller::clock::time_point gc_deadline) {
+    {
+      std::lock_guard lock{m_mutex};
+      m_delta_time = delta_time;
+      m_gc_deadline = gc_deadline;
+      m_pending = m_workers.size();
+      ++m_frame;
+    }
+    m_start.notify_all();
+    {
+      std::unique_lock lock{m_mutex};
+      m_done.wait(lock, [this] { return m_pending == 0; });
+    }
+
+    for (auto &worker : m_workers) {
+      if (auto error = std::exchange(worker->error, nullptr); error)
+        std::rethrow_exception(error);
+    }
+    // Workers are idle, their states can be used by this thread
+    for (auto &worker : m_workers)
+      worker->patches.replay();
+    for (auto &worker : m_workers) {
+      for (auto &f : std::exchange(worker->deferred, {}))
+        f();
+    }
+  }
+
+private:
+  struct script_worker {
+    sol::state lua;
+    gc_controller gc{lua};
+    sol::function factory;
+    std::vector<entt::entity> shard;
+    std::vector<sol::function> deferred;
+    deferred_patches patches;
+    std::exception_ptr error;
+  };
+
+  void _on_construct(entt::registry &registry, entt::entity entity) {
+    const auto &script = registry.get<ScriptComponent>(entity);
+    m_workers[script.worker]->shard.push_back(entity);
+  }
+  void _on_destroy(entt::registry &registry, entt::entity entity) {
+    const auto &script = registry.get<ScriptComponent>(entity);
+    auto &shard = m_workers[script.worker]->shard;
+    if (auto it = std::find(shard.begin(), shard.end(), entity);
+        it != shard.end()) {
+      *it = shard.back();
+      shard.pop_back();
+    }
+  }
+
+  void _run(std::size_t index) {
+    auto &worker = *m_workers[index];
+    deferred_patches::current() = &worker.patches;
+    std::size_t frame{0};
+    while (true) {
+      fsec delta_time;
+      gc_controller::clock::time_point gc_deadline;
+      {
+        std::unique_lock lock{m_mutex};
+        m_start.wait(lock, [&] { return m_stop || m_frame != frame; });
+        if (m_stop) return;
+        frame = m_frame;
+        delta_time = m_delta_time;
+        gc_deadline = m_gc_deadline;
+      }
+
+      try {
+        for (auto entity : worker.shard) {
+          auto &script = m_registry.get<ScriptComponent>(entity);
+          assert(script.binding.valid());
+          script.binding.call(script_hook::update, delta_time);
+        }
+        worker.gc.step_until(gc_deadline);
+      } catch (...) {
+        worker.error = std::current_exception();
+      }
+
+      {
+        std::lock_guard lock{m_mutex};
+        if (--m_pending == 0) m_done.notify_one();
+      }
+    }
+  }
+
+private:
+  entt::registry &m_registry;
+  std::vector<std::unique_ptr<script_worker>> m_workers;
+  std::vector<std::thread> m_threads;
+
+  std::mutex m_mutex;
+  std::condition_variable m_start;
+  std::condition_variable m_done;
+  std::size_t m_frame{0};
+  std::size_t m_pending{0};
+  fsec m_delta_time{0};
+  gc_controller::clock::time_point m_gc_deadline;
+  bool m_stop{false};
+};
@@ -7,7 +7,9 @@ end
 function node:update(dt)
   local transform = self.owner:get(self.id(), Transform)
   transform.x = transform.x + 1
-  print('node [#' .. self.id() .. '] update()', transform)
+  -- Data of self is kept in snapshots (see registry:save)
+  self.updates = (self.updates or 0) + 1
+  print('node [#' .. self.id() .. '] update() #' .. self.updates, transform)
 end
 
 function node:destroy()
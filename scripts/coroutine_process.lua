@@ -0,0 +1,28 @@
+local yield = coroutine.yield
+local wait, wait_signal, next_frame = entt.wait, entt.wait_signal, entt.next_frame
+
+-- Coroutine processes (functions), no ticks are counted by scripts
+scheduler:attach(
+  function(self)
+    print('[lua] silo: opening')
+    yield(wait(2))
+    print('[lua] silo: open')
+    entt.notify('silo_open', 'silo #1')
+  end,
+  function(self)
+    for i = 3, 1, -1 do
+      print('[lua] countdown: ' .. i)
+      yield(wait(0.5))
+    end
+  end
+)
+
+-- Parked until notified, no calls into lua in the meantime
+local launcher = function(self)
+  self.set_hook('succeeded', function() print('[lua] launcher: done') end)
+  local silo = yield(wait_signal('silo_open'))
+  print('[lua] launch from ' .. silo)
+  yield(next_frame())
+  -- Returning succeeds the process, so does self.succeed()
+end
+scheduler:attach(launcher)
@@ -1,4 +1,12 @@
-function define_event()
+-- options (optional):
+--  pooled = true  instances are recycled once delivered (listeners must not
+--                 keep them, senders must not reuse them after trigger or
+--                 enqueue), construct with no arguments and set fields to
+--                 avoid allocations: local evt = Foo() evt.value = 1
+--  values = true  value-typed event, has no instances, use
+--                 dispatcher:trigger_values(Foo, ...) / enqueue_values
+--                 (listeners receive values as arguments)
+function define_event(options)
   assert(BaseScriptEvent ~= nil)
 
   local ScriptEvent = {}
@@ -12,12 +20,22 @@ function define_event()
 
   setmetatable(ScriptEvent, {
     __index = BaseScriptEvent,     -- This is what makes the inheritance work
-    __call = function(cls, ...)
-      local self = setmetatable({}, cls)
-      self:_init(... or {})
+    __call = function(cls, evt)
+      local pool = rawget(cls, '__pool')
+      local self = pool and table.remove(pool)
+      if self then
+        rawset(self, '__in_pool', nil)
+      else
+        self = setmetatable({}, cls)
+      end
+      if evt then
+        self:_init(evt)
+      end
       return self
     end
   })
+  -- Dense id, only listeners of this event type are going to be notified
+  BaseScriptEvent.define(ScriptEvent, options)
   assert(ScriptEvent.type_id() == BaseScriptEvent.type_id())
   return ScriptEvent
 end
@@ -1,12 +1,20 @@
 local view = registry:runtime_view(Transform)
 assert(view:size_hint() > 0)
 
+-- Might be kept (e.g. in a global) and iterated every frame
+local query = registry:query(Transform)
+
 local koopa = registry:create()
 registry:emplace(koopa, Transform(100, -200))
 transform = registry:get(koopa, Transform)
 print('Koopa position = ' .. tostring(transform))
 
 assert(view:size_hint() == 2)
+assert(query:size_hint() == 2)
+
+query:each(function(entity, transform)
+  print('Entity: ' .. entity .. ' position = ' .. tostring(transform))
+end)
 
 view:each(function(entity)
   print('Remove Transform from entity: ' .. entity)
@@ -14,3 +22,4 @@ view:each(function(entity)
 end)
 
 assert(view:size_hint() == 0)
+assert(query:size_hint() == 0)
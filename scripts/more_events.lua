@@ -17,9 +17,21 @@ listeners.connections[0] = dispatcher:connect(TestEvent, listeners.receive)
 Bar = define_event()
 listeners.connections[1] = dispatcher:connect(Bar, listeners.notify)
 
+-- Array of Bar events (triggered or queued), delivered by dispatcher:update()
+listeners.connections[3] = dispatcher:connect_batch(Bar, function(events)
+  print('[lua/ batch] ' .. #events .. ' Bar(s)')
+end)
+
 dispatcher:trigger(TestEvent('lua', 123))
 dispatcher:trigger(Bar())
 
+-- Value-typed event, no table is created (neither by trigger nor enqueue)
+Damage = define_event({ values = true })
+listeners.connections[2] = dispatcher:connect(Damage, function(target, amount)
+  print('[lua/ Damage] ' .. target .. ' -' .. amount)
+end)
+dispatcher:trigger_values(Damage, 'goomba', 10)
+
 -- return value (connection) discarded
 -- The following callback is going to be disconnected during the garbage collection step
 dispatcher:connect(TestEvent, listeners.notify)
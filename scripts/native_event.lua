@@ -10,3 +10,9 @@ conn = dispatcher:connect(TestEvent, test_event_handler)
 
 -- The event is going to be received by listeners defined in either Lua or c++
 dispatcher:trigger(TestEvent('lua', 0))
+
+-- All TestEvents (e.g. sent by the network thread) in one call per
+-- dispatcher:update(), events are valid only during the call
+batch_conn = dispatcher:connect_batch(TestEvent, function(events)
+  print('[lua:batch] ' .. #events .. ' TestEvent(s), first: ' .. tostring(events[1]))
+end)
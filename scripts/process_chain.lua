@@ -7,6 +7,9 @@ function my_proc:update(dt)
   self.fail()
 end
 
+-- Native processes might be attached already (see parallel_scheduler)
+local num_processes = scheduler:size()
+
 scheduler:attach(
   test_process.new("open_silo"),
   my_proc,
@@ -14,4 +17,4 @@ scheduler:attach(
 )
 
 assert(not scheduler:empty())
-assert(scheduler:size() == 1)
+assert(scheduler:size() == num_processes + 1)
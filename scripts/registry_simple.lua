@@ -5,7 +5,77 @@ assert(registry:has(bowser, Transform))
 assert(registry:has(bowser, Transform.type_id()))
 
 assert(not registry:any_of(bowser, -1, -2))
+assert(registry:all_of(bowser, Transform) and not registry:all_of(bowser, Transform, -1))
+assert(registry:none_of(bowser, -1, -2))
 
 transform = registry:get(bowser, Transform)
 transform.x = transform.x + 10
 print('Bowser position = ' .. tostring(transform))
+
+-- Bulk variants, each is a single call into c++
+local level = entt.registry.new()
+local goombas = level:create_many(100)
+assert(#goombas == 100)
+level:emplace_many(goombas, Transform, Transform(0, 0))
+assert(level:has(goombas[1], Transform))
+
+-- Single field of all components, numeric loop without proxies
+local xs = level:column(Transform, 'x')
+assert(#xs == 100)
+for i = 1, #xs do
+  xs[i] = xs[i] + i
+end
+assert(level:get(xs:entity(100), Transform).x == 100)
+
+-- Incremental: visits only entities touched since the last each
+local moved = level:observe{ update = {Transform} }
+level:get(goombas[1], Transform).x = 7 -- Writes through proxies patch
+xs[2] = xs[2] + 1                      -- so do writes to columns
+local num_moved = 0
+moved:each(function(entity) num_moved = num_moved + 1 end)
+assert(num_moved == 2 and #moved == 0)
+moved:disconnect()
+
+-- A destroyed entity recycled before the drain is reported once, as the new
+-- one (the slot is reused)
+local changed = level:observe{ update = {Transform}, destroy = {Transform} }
+local doomed = level:create()
+level:emplace(doomed, Transform(0, 0))
+level:destroy(doomed)
+local recycled = level:create()
+level:emplace(recycled, Transform(0, 0))
+level:get(recycled, Transform).x = 1
+local drained = {}
+changed:each(function(entity) drained[#drained + 1] = entity end)
+assert(#drained == 1 and drained[1] == recycled)
+changed:disconnect()
+
+-- Native loop over all entities with Transform (see registry:kernels())
+assert(level:apply('translate', {Transform}, 1, 2))
+assert(level:get(goombas[1], Transform).y == 2)
+
+-- Owning group (see register_meta_group), Velocity is owned (packed),
+-- Transform is not
+local movement = level:group('movement')
+assert(movement ~= nil and #movement == 0)
+level:emplace(goombas[1], Velocity(1, 1))
+level:emplace(goombas[2], Velocity(2, 2))
+assert(#movement == 2)
+movement:each(function(entity, velocity, transform)
+  transform.x = transform.x + velocity.x
+end)
+assert(level:get(goombas[2], Transform).x == 6)
+local num_moving = 0
+movement:each_entity(function(entity) num_moving = num_moving + 1 end)
+assert(num_moving == 2)
+level:remove(goombas[1], Velocity)
+level:remove(goombas[2], Velocity)
+
+-- Binary snapshot, restored into a new (empty) registry
+assert(level:save('level.snapshot'))
+local copy = entt.registry.new()
+assert(copy:load('level.snapshot'))
+assert(copy:size() == level:size())
+assert(copy:get(goombas[100], Transform).x == 101)
+assert(level:remove_many(goombas, Transform) == 100)
+level:destroy_many(goombas)
@@ -0,0 +1,114 @@
+// Compiles scripts to bytecode and writes them into a single pack,
+// loaded at runtime by script_pack (utility/script_pack.hpp).
+// Usage: luapack [--strip] <output> <script>...
+// Scripts are stored under given names (paths relative to working dir).
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "script_pack.hpp"
+
+namespace {
+
+struct compiled_script {
+  std::string name;
+  std::string bytecode;
+  std::int64_t mtime;
+};
+
+int writer(lua_State *, const void *p, std::size_t size, void *ud) {
+  static_cast<std::string *>(ud)->append(static_cast<const char *>(p), size);
+  return 0;
+}
+
+[[nodiscard]] bool compile(lua_State *L, const std::string &filename,
+                           bool strip, compiled_script &out) {
+  if (luaL_loadfile(L, filename.c_str()) != 0) {
+    std::cerr << lua_tostring(L, -1) << std::endl;
+    lua_pop(L, 1);
+    return false;
+  }
+  out.name = std::filesystem::path{filename}.generic_string();
+  out.mtime = script_pack_format::get_file_time(filename);
+#if LUA_VERSION_NUM >= 503
+  lua_dump(L, &writer, &out.bytecode, strip);
+#else
+  (void)strip;
+  lua_dump(L, &writer, &out.bytecode);
+#endif
+  lua_pop(L, 1);
+  return true;
+}
+
+void write_pack(std::ostream &os, std::vector<compiled_script> &scripts) {
+  using namespace script_pack_format;
+
+  std::sort(scripts.begin(), scripts.end(),
+            [](const auto &a, const auto &b) { return a.name < b.name; });
+
+  header h{};
+  std::copy(std::begin(magic), std::end(magic), h.magic);
+  h.version = version;
+  h.lua_version = LUA_VERSION_NUM;
+  h.count = static_cast<std::uint32_t>(scripts.size());
+
+  auto offset = sizeof(header) + scripts.size() * sizeof(entry);
+  std::vector<entry> entries(scripts.size());
+  for (std::size_t i = 0; i < scripts.size(); ++i) {
+    entries[i].name_offset = static_cast<std::uint32_t>(offset);
+    entries[i].name_size = static_cast<std::uint32_t>(scripts[i].name.size());
+    entries[i].mtime = scripts[i].mtime;
+    offset += scripts[i].name.size();
+  }
+  for (std::size_t i = 0; i < scripts.size(); ++i) {
+    entries[i].data_offset = static_cast<std::uint32_t>(offset);
+    entries[i].data_size =
+      static_cast<std::uint32_t>(scripts[i].bytecode.size());
+    offset += scripts[i].bytecode.size();
+  }
+
+  os.write(reinterpret_cast<const char *>(&h), sizeof(header));
+  os.write(reinterpret_cast<const char *>(entries.data()),
+           static_cast<std::streamsize>(entries.size() * sizeof(entry)));
+  for (const auto &script : scripts)
+    os.write(script.name.data(), static_cast<std::streamsize>(script.name.size()));
+  for (const auto &script : scripts) {
+    os.write(script.bytecode.data(),
+             static_cast<std::streamsize>(script.bytecode.size()));
+  }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int first = 1;
+  bool strip{false};
+  if (argc > 1 && std::string_view{argv[1]} == "--strip") {
+    strip = true;
+    ++first;
+  }
+  if (argc - first < 1) {
+    std::cerr << "usage: luapack [--strip] <output> <script>..." << std::endl;
+    return -1;
+  }
+  const std::string output{argv[first++]};
+
+  auto *L = luaL_newstate();
+  std::vector<compiled_script> scripts(static_cast<std::size_t>(argc - first));
+  auto ok = true;
+  for (auto i = first; i < argc && ok; ++i)
+    ok = compile(L, argv[i], strip, scripts[static_cast<std::size_t>(i - first)]);
+  lua_close(L);
+  if (!ok) return -1;
+
+  std::ofstream f{output, std::ios::binary};
+  if (!f.is_open()) {
+    std::cerr << "failed to open: " << output << std::endl;
+    return -1;
+  }
+  write_pack(f, scripts);
+  return f.good() ? 0 : -1;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include "profiler.hpp"
+#include "sol/sol.hpp"
+
+// Steps the incremental collector of a lua state only within a time budget
+// (what's left of a frame), instead of a fixed step every frame.
+// The step size follows the allocation rate (KiB allocated between frames),
+// a full cycle is forced only when memory crosses a threshold, re-armed
+// relative to the memory left after every finished cycle.
+// The automatic collector is held back for the lifetime of a controller
+// (unless config::manual is false), only as a backstop in case step() isn't
+// called often enough.
+class gc_controller {
+public:
+  using clock = std::chrono::steady_clock;
+
+  struct config {
+    bool manual{true};
+    // Spent even on frames without time left, so the collector keeps up
+    clock::duration min_budget{std::chrono::microseconds{100}};
+    clock::duration max_budget{std::chrono::milliseconds{4}};
+    // KiB per lua_gc(LUA_GCSTEP)
+    int min_step{4};
+    int max_step{1024};
+    // Full cycle above (KiB), re-armed to pause (percent) of the memory
+    // left after a cycle, but never below the initial threshold
+    std::size_t threshold{64 * 1024};
+    int pause{200};
+    // Pause (percent) of the automatic collector while manual, it starts
+    // only far above the threshold. 0 = stopped, memory is reclaimed only
+    // by step().
+    int backstop_pause{400};
+  };
+  struct frame_stats {
+    clock::duration time{0};
+    std::size_t steps{0};
+    bool full_cycle{false};
+    std::size_t memory{0}; // KiB, after the step
+  };
+
+  explicit gc_controller(lua_State *L) : gc_controller{L, config{}} {}
+  gc_controller(lua_State *L, const config &cfg)
+      : m_state{L}, m_config{cfg}, m_last_memory{_memory()},
+        m_threshold{cfg.threshold} {
+    assert(m_state);
+    if (!m_config.manual) return;
+    if (m_config.backstop_pause > 0) {
+      m_pause = lua_gc(m_state, LUA_GCSETPAUSE, m_config.backstop_pause);
+    } else {
+      lua_gc(m_state, LUA_GCSTOP, 0);
+    }
+  }
+  gc_controller(const gc_controller &) = delete;
+  ~gc_controller() {
+    if (!m_config.manual) return;
+    if (m_config.backstop_pause > 0) {
+      lua_gc(m_state, LUA_GCSETPAUSE, m_pause);
+    } else {
+      lua_gc(m_state, LUA_GCRESTART, 0);
+    }
+  }
+
+  gc_controller &operator=(const gc_controller &) = delete;
+
+  // Call once per frame, when the state is idle (after systems, scheduler
+  // etc.), with the remaining frame time
+  void step(clock::duration budget) {
+    PROFILER_ZONE("gc", "step");
+    const auto begin = clock::now();
+    budget = std::clamp(budget, m_config.min_budget, m_config.max_budget);
+
+    // Exponential moving average of KiB allocated per frame
+    const auto memory = _memory();
+    const auto allocated =
+      memory > m_last_memory ? static_cast<double>(memory - m_last_memory) : 0.0;
+    m_allocation_rate = m_allocation_rate * 0.75 + allocated * 0.25;
+
+    m_last = frame_stats{};
+    if (memory >= m_threshold) {
+      lua_gc(m_state, LUA_GCCOLLECT, 0);
+      m_last.full_cycle = true;
+      _rearm();
+    } else {
+      // A few steps per frame are enough to keep up with allocations,
+      // smaller ones would only add overhead of the deadline checks
+      const auto step_size =
+        std::clamp(static_cast<int>(m_allocation_rate / 4.0), m_config.min_step,
+                   m_config.max_step);
+      const auto deadline = begin + budget;
+      do {
+        ++m_last.steps;
+        // End of a cycle
+        if (lua_gc(m_state, LUA_GCSTEP, step_size)) {
+          _rearm();
+          break;
+        }
+      } while (clock::now() < deadline);
+    }
+
+    m_last_memory = _memory();
+    m_last.memory = m_last_memory;
+    m_last.time = clock::now() - begin;
+  }
+  void step_until(clock::time_point deadline) { step(deadline - clock::now()); }
+
+  [[nodiscard]] const frame_stats &last() const { return m_last; }
+  // KiB per frame
+  [[nodiscard]] double allocation_rate() const { return m_allocation_rate; }
+  [[nodiscard]] const config &get_config() const { return m_config; }
+  // KiB, a full cycle is forced above
+  [[nodiscard]] std::size_t threshold() const { return m_threshold; }
+
+private:
+  [[nodiscard]] std::size_t _memory() const {
+    return static_cast<std::size_t>(lua_gc(m_state, LUA_GCCOUNT, 0));
+  }
+  // Otherwise a heap grown above the threshold would be fully collected
+  // every frame
+  void _rearm() {
+    const auto live = _memory();
+    m_threshold = std::max(
+      m_config.threshold,
+      live * static_cast<std::size_t>(std::max(m_config.pause, 100)) / 100);
+  }
+
+private:
+  lua_State *m_state;
+  const config m_config;
+  std::size_t m_last_memory;
+  std::size_t m_threshold;
+  int m_pause{0}; // Of the automatic collector, restored in the destructor
+  double m_allocation_rate{0.0};
+  frame_stats m_last;
+};
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Custom allocators for lua states (lua_Alloc), e.g.
+//  pool_allocator pool{64 << 20};
+//  sol::state lua{sol::default_at_panic, &pool_allocator::alloc, &pool};
+// An allocator has to outlive its state(s).
+// Both keep track of used memory and refuse to grow beyond a limit
+// (0 = unlimited), lua raises "not enough memory" error then.
+
+namespace detail {
+
+class memory_budget {
+public:
+  explicit memory_budget(std::size_t limit) : m_limit{limit} {}
+
+  [[nodiscard]] std::size_t used() const { return m_used; }
+  [[nodiscard]] std::size_t peak() const { return m_peak; }
+  [[nodiscard]] std::size_t limit() const { return m_limit; }
+  void set_limit(std::size_t limit) { m_limit = limit; }
+
+protected:
+  [[nodiscard]] bool _can_grow(std::size_t osize, std::size_t nsize) const {
+    return m_limit == 0 || nsize <= osize || m_used - osize + nsize <= m_limit;
+  }
+  void _resize(std::size_t osize, std::size_t nsize) {
+    m_used = m_used - osize + nsize;
+    m_peak = std::max(m_peak, m_used);
+  }
+
+private:
+  std::size_t m_limit;
+  std::size_t m_used{0};
+  std::size_t m_peak{0};
+};
+
+} // namespace detail
+
+// Size-class free lists for small blocks (most of lua objects: strings,
+// tables, closures, userdata), carved from big chunks. Larger blocks go to
+// malloc. Not thread-safe, use one allocator per state.
+class pool_allocator : public detail::memory_budget {
+  static constexpr std::size_t granularity = 16; // >= LUAI_MAXALIGN
+  static constexpr std::size_t max_small_size = 512;
+  static constexpr std::size_t num_classes = max_small_size / granularity;
+  static constexpr std::size_t chunk_size = 64 * 1024;
+
+public:
+  explicit pool_allocator(std::size_t limit = 0) : memory_budget{limit} {}
+  pool_allocator(const pool_allocator &) = delete;
+
+  pool_allocator &operator=(const pool_allocator &) = delete;
+
+  static void *alloc(void *ud, void *ptr, std::size_t osize,
+                     std::size_t nsize) {
+    return static_cast<pool_allocator *>(ud)->_realloc(ptr, osize, nsize);
+  }
+
+  // Memory taken from the system (chunks + large blocks)
+  [[nodiscard]] std::size_t reserved() const {
+    return m_chunks.size() * chunk_size + m_large;
+  }
+
+private:
+  struct free_block {
+    free_block *next;
+  };
+
+  [[nodiscard]] static constexpr std::size_t _class_of(std::size_t size) {
+    return (size + granularity - 1) / granularity - 1;
+  }
+  [[nodiscard]] static constexpr bool _is_small(std::size_t size) {
+    return size <= max_small_size;
+  }
+
+  void *_realloc(void *ptr, std::size_t osize, std::size_t nsize) {
+    if (!ptr) osize = 0; // Type of an object (Lua 5.2+), not a size
+    if (nsize == 0) {
+      if (ptr) _free(ptr, osize);
+      _resize(osize, 0);
+      return nullptr;
+    }
+    if (!_can_grow(osize, nsize)) return nullptr;
+
+    void *block{nullptr};
+    if (ptr && _is_small(osize) && _is_small(nsize) &&
+        _class_of(osize) == _class_of(nsize)) {
+      block = ptr; // Fits in the same block
+    } else if (ptr && !_is_small(osize) && !_is_small(nsize)) {
+      block = std::realloc(ptr, nsize);
+      if (block) m_large = m_large - osize + nsize;
+    } else {
+      block = _allocate(nsize);
+      if (block && ptr) {
+        std::memcpy(block, ptr, std::min(osize, nsize));
+        _free(ptr, osize);
+      }
+    }
+    if (block) _resize(osize, nsize);
+    return block;
+  }
+
+  [[nodiscard]] void *_allocate(std::size_t size) {
+    if (!_is_small(size)) {
+      auto *block = std::malloc(size);
+      if (block) m_large += size;
+      return block;
+    }
+
+    auto &head = m_free_lists[_class_of(size)];
+    if (!head) _refill(_class_of(size));
+    if (auto *block = head; block) {
+      head = block->next;
+      return block;
+    }
+    return nullptr;
+  }
+  void _free(void *ptr, std::size_t size) {
+    if (!_is_small(size)) {
+      m_large -= size;
+      return std::free(ptr);
+    }
+
+    auto &head = m_free_lists[_class_of(size)];
+    head = new (ptr) free_block{head};
+  }
+  // Carves blocks of a given class from the current chunk (or a new one)
+  void _refill(std::size_t size_class) {
+    const auto block_size = (size_class + 1) * granularity;
+    if (m_chunks.empty() || m_offset + block_size > chunk_size) {
+      m_chunks.emplace_back(new (std::nothrow) std::byte[chunk_size]);
+      if (!m_chunks.back()) {
+        m_chunks.pop_back();
+        return;
+      }
+      m_offset = 0;
+    }
+    // Up to 32 blocks at once, so a rarely used class doesn't take a chunk
+    auto &head = m_free_lists[size_class];
+    auto *chunk = m_chunks.back().get();
+    for (int i = 0; i < 32 && m_offset + block_size <= chunk_size; ++i) {
+      head = new (chunk + m_offset) free_block{head};
+      m_offset += block_size;
+    }
+  }
+
+private:
+  std::array<free_block *, num_classes> m_free_lists{};
+  std::vector<std::unique_ptr<std::byte[]>> m_chunks;
+  std::size_t m_offset{0}; // In the last chunk
+  std::size_t m_large{0};
+};
+
+// Bump allocator, individual blocks are never freed (shrinking happens in
+// place), the whole memory is released at once with the allocator.
+// Meant for short-lived states (e.g. one per level) that allocate a lot and
+// are closed as a whole. Not thread-safe.
+class arena_allocator : public detail::memory_budget {
+  static constexpr std::size_t alignment = 16; // >= LUAI_MAXALIGN
+
+public:
+  explicit arena_allocator(std::size_t limit = 0,
+                           std::size_t block_size = 1024 * 1024)
+      : memory_budget{limit}, m_block_size{block_size} {}
+  arena_allocator(const arena_allocator &) = delete;
+
+  arena_allocator &operator=(const arena_allocator &) = delete;
+
+  static void *alloc(void *ud, void *ptr, std::size_t osize,
+                     std::size_t nsize) {
+    return static_cast<arena_allocator *>(ud)->_realloc(ptr, osize, nsize);
+  }
+
+  [[nodiscard]] std::size_t reserved() const { return m_reserved; }
+
+  // Frees everything, only after all states using the arena are closed
+  void release() {
+    m_blocks.clear();
+    m_current = nullptr;
+    m_offset = m_capacity = m_reserved = 0;
+    _resize(used(), 0);
+  }
+
+private:
+  void *_realloc(void *ptr, std::size_t osize, std::size_t nsize) {
+    if (!ptr) osize = 0;
+    if (nsize == 0) return nullptr;
+    if (ptr && nsize <= osize) return ptr;
+    if (!_can_grow(osize, nsize)) return nullptr;
+
+    auto *block = _allocate(nsize);
+    if (block && ptr) std::memcpy(block, ptr, osize);
+    if (block) _resize(osize, nsize);
+    return block;
+  }
+
+  [[nodiscard]] void *_allocate(std::size_t size) {
+    size = (size + alignment - 1) & ~(alignment - 1);
+    // Big blocks get their own allocation, current one is kept
+    if (size > m_block_size / 4) {
+      auto &block = m_blocks.emplace_back(new (std::nothrow) std::byte[size]);
+      if (block) m_reserved += size;
+      return block.get();
+    }
+    if (m_offset + size > m_capacity) {
+      auto &block =
+        m_blocks.emplace_back(new (std::nothrow) std::byte[m_block_size]);
+      if (!block) return nullptr;
+      m_current = block.get();
+      m_offset = 0;
+      m_capacity = m_block_size;
+      m_reserved += m_block_size;
+    }
+    auto *ptr = m_current + m_offset;
+    m_offset += size;
+    return ptr;
+  }
+
+private:
+  const std::size_t m_block_size;
+  std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+  std::byte *m_current{nullptr};
+  std::size_t m_offset{0};
+  std::size_t m_capacity{0};
+  std::size_t m_reserved{0};
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+#if WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file.
+class mapped_file {
+public:
+  mapped_file() = default;
+  mapped_file(const mapped_file &) = delete;
+  ~mapped_file() { close(); }
+
+  mapped_file &operator=(const mapped_file &) = delete;
+
+  bool open(const std::filesystem::path &p) {
+    close();
+#if WIN32
+    auto file = CreateFileW(p.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size{};
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+      if (auto mapping =
+            CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+          mapping) {
+        m_data = static_cast<const char *>(
+          MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(mapping);
+        if (m_data) m_size = static_cast<std::size_t>(size.QuadPart);
+      }
+    }
+    CloseHandle(file);
+#else
+    const auto fd = ::open(p.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+    if (struct stat st {}; fstat(fd, &st) == 0 && st.st_size > 0) {
+      if (auto *data = mmap(nullptr, static_cast<std::size_t>(st.st_size),
+                            PROT_READ, MAP_PRIVATE, fd, 0);
+          data != MAP_FAILED) {
+        m_data = static_cast<const char *>(data);
+        m_size = static_cast<std::size_t>(st.st_size);
+      }
+    }
+    ::close(fd);
+#endif
+    return m_data != nullptr;
+  }
+  void close() {
+    if (!m_data) return;
+#if WIN32
+    UnmapViewOfFile(m_data);
+#else
+    munmap(const_cast<char *>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+  }
+
+  [[nodiscard]] const char *data() const { return m_data; }
+  [[nodiscard]] std::size_t size() const { return m_size; }
+
+private:
+  const char *m_data{nullptr};
+  std::size_t m_size{0};
+};
@@ -1,15 +1,55 @@
 #pragma once
 
+#include <atomic>
+#include "entt/container/dense_map.hpp"
 #include "entt/meta/factory.hpp"
 #include "entt/meta/resolve.hpp"
 #include "sol/sol.hpp"
 
-[[nodiscard]] entt::id_type get_type_id(const sol::table &obj) {
+// Raw key under which a resolved type id is stored, read with lua_rawget so
+// that deduce_type never has to call the 'type_id' function of a type.
+inline constexpr const char *type_id_key = "__type_id";
+
+[[nodiscard]] inline entt::id_type get_type_id(const sol::table &obj) {
   const auto f = obj["type_id"].get<sol::function>();
   assert(f.valid() && "type_id not exposed to lua!");
   return f.valid() ? f().get<entt::id_type>() : -1;
 }
 
+namespace detail {
+
+[[nodiscard]] inline bool rawget_id(lua_State *L, const char *key,
+                                    entt::id_type &id) {
+  if (lua_type(L, -1) != LUA_TTABLE) return false;
+  lua_pushstring(L, key);
+  lua_rawget(L, -2);
+  const auto found = lua_type(L, -1) == LUA_TNUMBER;
+  if (found) id = static_cast<entt::id_type>(lua_tointeger(L, -1));
+  lua_pop(L, 1);
+  return found;
+}
+
+} // namespace detail
+
+// Looks for an id (raw field) in the object itself, then in its metatable.
+template <typename T>
+[[nodiscard]] bool get_stamped_id(const T &obj, const char *key,
+                                  entt::id_type &id) {
+  lua_State *L = obj.lua_state();
+  obj.push();
+  auto found = detail::rawget_id(L, key, id);
+  if (!found && lua_getmetatable(L, -1)) {
+    found = detail::rawget_id(L, key, id);
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 1);
+  return found;
+}
+template <typename T>
+[[nodiscard]] bool get_stamped_type_id(const T &obj, entt::id_type &type_id) {
+  return get_stamped_id(obj, type_id_key, type_id);
+}
+
 template <typename T> [[nodiscard]] entt::id_type deduce_type(T &&obj) {
   switch (obj.get_type()) {
   // in lua: registry:has(e, Transform.type_id())
@@ -17,12 +57,38 @@ template <typename T> [[nodiscard]] entt::id_type deduce_type(T &&obj) {
     return obj.template as<entt::id_type>();
   // in lua: registry:has(e, Transform)
   case sol::type::table:
+  // in lua: registry:emplace(e, Transform(1, 2))
+  case sol::type::userdata:
+    if (entt::id_type type_id; get_stamped_type_id(obj, type_id))
+      return type_id;
     return get_type_id(obj);
   }
   assert(false);
   return -1;
 }
 
+// Stores type id of T (as a raw field) in the usertype table and in all
+// metatables that sol2 creates for T, so instances are covered as well.
+template <typename T> void stamp_type_id(sol::table type) {
+  const auto type_id = entt::type_hash<T>::value();
+  type.raw_set(type_id_key, type_id);
+
+  lua_State *L = type.lua_state();
+  for (const auto &name : {sol::usertype_traits<T>::metatable(),
+                           sol::usertype_traits<const T>::metatable(),
+                           sol::usertype_traits<T *>::metatable(),
+                           sol::usertype_traits<const T *>::metatable(),
+                           sol::usertype_traits<sol::d::u<T>>::metatable()}) {
+    luaL_getmetatable(L, name.c_str());
+    if (lua_type(L, -1) == LUA_TTABLE) {
+      lua_pushstring(L, type_id_key);
+      lua_pushinteger(L, static_cast<lua_Integer>(type_id));
+      lua_rawset(L, -3);
+    }
+    lua_pop(L, 1);
+  }
+}
+
 // @see
 // https://github.com/skypjack/entt/wiki/Crash-Course:-runtime-reflection-system
 
@@ -44,3 +110,46 @@ inline auto invoke_meta_func(entt::id_type type_id, entt::id_type function_id,
   return invoke_meta_func(entt::resolve(type_id), function_id,
                           std::forward<Args>(args)...);
 }
+
+// Incremented by every register_meta_* call, outdates all dispatch caches.
+[[nodiscard]] inline std::atomic<std::size_t> &dispatch_epoch() {
+  static std::atomic<std::size_t> epoch{0};
+  return epoch;
+}
+inline void invalidate_dispatch_caches() { ++dispatch_epoch(); }
+
+// Maps a type id to a table of typed function pointers (Table), exposed by
+// a reflected type as a meta function (Table::id) returning const Table *.
+// Each type is resolved once, subsequent lookups skip entt::resolve, the
+// meta function lookup and meta_any boxing of arguments.
+// Every thread has its own cache (scripts might run on worker threads).
+template <typename Table> class dispatch_cache {
+public:
+  [[nodiscard]] static const Table *find(entt::id_type type_id) {
+    static thread_local dispatch_cache cache{};
+    if (const auto epoch = dispatch_epoch().load(); cache.m_epoch != epoch) {
+      cache.m_tables.clear();
+      cache.m_epoch = epoch;
+    }
+    if (auto it = cache.m_tables.find(type_id); it != cache.m_tables.end())
+      return it->second;
+
+    // Unknown types are cached as well (nullptr)
+    return cache.m_tables.emplace(type_id, _resolve(type_id)).first->second;
+  }
+
+private:
+  [[nodiscard]] static const Table *_resolve(entt::id_type type_id) {
+    if (auto &&meta_type = entt::resolve(type_id); meta_type) {
+      if (auto &&meta_function = meta_type.func(Table::id); meta_function) {
+        if (auto &&table = meta_function.invoke({}); table)
+          return table.template cast<const Table *>();
+      }
+    }
+    return nullptr;
+  }
+
+private:
+  std::size_t m_epoch{dispatch_epoch().load()};
+  entt::dense_map<entt::id_type, const Table *> m_tables;
+};
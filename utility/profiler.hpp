@@ -0,0 +1,276 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+#include "entt/container/dense_map.hpp"
+#include "sol/sol.hpp"
+
+// Call counts and cumulative time of hooks, bindings and listeners (zones),
+// optionally Lua functions (sampled with lua_sethook).
+// When disabled, a zone costs a single (relaxed) atomic load.
+// Every thread records into its own buffers, read them (stats, write_trace)
+// only when other threads are idle (e.g. between frames).
+class profiler {
+public:
+  using clock = std::chrono::steady_clock;
+
+  struct zone_key {
+    std::string_view category;
+    std::string_view name;
+
+    [[nodiscard]] bool operator==(const zone_key &other) const {
+      return category == other.category && name == other.name;
+    }
+  };
+  struct zone_key_hash {
+    [[nodiscard]] std::size_t operator()(const zone_key &key) const {
+      const std::hash<std::string_view> hash{};
+      return hash(key.category) ^ (hash(key.name) << 1);
+    }
+  };
+  struct stats {
+    std::uint64_t count{0};
+    clock::duration total{0};
+  };
+  using stats_map = entt::dense_map<zone_key, stats, zone_key_hash>;
+
+  [[nodiscard]] static profiler &get() {
+    static profiler instance;
+    return instance;
+  }
+
+  [[nodiscard]] bool enabled() const {
+    return m_enabled.load(std::memory_order_relaxed);
+  }
+  void enable(bool enabled) {
+    m_enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  // Records trace events during next n frames
+  void capture(std::size_t num_frames) { m_capture.store(num_frames); }
+  [[nodiscard]] bool capturing() const {
+    return m_capture.load(std::memory_order_relaxed) > 0;
+  }
+  // Marks the end of a frame (call once per frame, on the main thread)
+  void frame() {
+    if (auto n = m_capture.load(); n > 0) m_capture.store(n - 1);
+    ++m_frame;
+  }
+
+  // Names must outlive the profiler (string literals, type names),
+  // @see intern
+  void record(std::string_view category, std::string_view name,
+              clock::time_point begin, clock::time_point end) {
+    auto &data = _local();
+    auto &s = data.zones[zone_key{category, name}];
+    ++s.count;
+    s.total += end - begin;
+    if (capturing())
+      data.events.push_back({category, name, begin, end - begin});
+  }
+  // Returns a stable copy of a (dynamic) name
+  [[nodiscard]] std::string_view intern(std::string_view name) {
+    std::lock_guard lock{m_mutex};
+    return *m_names.emplace(name).first;
+  }
+
+  // Merged stats of all threads
+  [[nodiscard]] stats_map collect() const {
+    stats_map result;
+    std::lock_guard lock{m_mutex};
+    for (const auto &data : m_threads) {
+      for (const auto &[key, s] : data->zones) {
+        auto &merged = result[key];
+        merged.count += s.count;
+        merged.total += s.total;
+      }
+    }
+    return result;
+  }
+  void reset() {
+    std::lock_guard lock{m_mutex};
+    for (auto &data : m_threads) {
+      data->zones.clear();
+      data->events.clear();
+    }
+  }
+
+  // Chrome trace-event format (chrome://tracing, Perfetto)
+  bool write_trace(const std::string &path) const {
+    std::ofstream f{path};
+    if (!f.is_open()) return false;
+
+    using usec = std::chrono::duration<double, std::micro>;
+    f << "{\"traceEvents\": [\n";
+    auto first = true;
+    std::lock_guard lock{m_mutex};
+    for (const auto &data : m_threads) {
+      for (const auto &e : data->events) {
+        f << (first ? "" : ",\n") << "  {\"name\": \"" << _escape(e.name)
+          << "\", \"cat\": \"" << e.category
+          << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << data->id
+          << ", \"ts\": " << usec{e.begin - m_epoch}.count()
+          << ", \"dur\": " << usec{e.duration}.count() << "}";
+        first = false;
+      }
+    }
+    f << "\n]}\n";
+    return f.good();
+  }
+
+  // Attributes time to Lua functions: every 'instructions' VM instructions
+  // the time since the previous sample goes to the running function.
+  // 0 = off. Replaces a hook that is already set (e.g. by a debugger).
+  static void sample(lua_State *L, int instructions) {
+    if (instructions > 0) {
+      lua_sethook(L, &profiler::_sample_hook, LUA_MASKCOUNT, instructions);
+    } else {
+      lua_sethook(L, nullptr, 0, 0);
+    }
+  }
+
+  // Scoped measurement
+  class zone {
+  public:
+    zone(std::string_view category, std::string_view name)
+        : m_category{category}, m_name{name},
+          m_active{profiler::get().enabled()} {
+      if (m_active) m_begin = clock::now();
+    }
+    zone(const zone &) = delete;
+    ~zone() {
+      if (m_active)
+        profiler::get().record(m_category, m_name, m_begin, clock::now());
+    }
+
+    zone &operator=(const zone &) = delete;
+
+  private:
+    std::string_view m_category;
+    std::string_view m_name;
+    clock::time_point m_begin;
+    bool m_active;
+  };
+
+private:
+  profiler() = default;
+
+  struct trace_event {
+    std::string_view category;
+    std::string_view name;
+    clock::time_point begin;
+    clock::duration duration;
+  };
+  struct thread_data {
+    std::uint32_t id;
+    stats_map zones;
+    std::vector<trace_event> events;
+    // Sampling
+    clock::time_point last_sample;
+    std::size_t last_frame{0};
+  };
+
+  [[nodiscard]] static std::string _escape(std::string_view str) {
+    std::string result;
+    result.reserve(str.size());
+    for (const auto c : str) {
+      if (c == '"' || c == '\\') result += '\\';
+      result += c;
+    }
+    return result;
+  }
+
+  [[nodiscard]] thread_data &_local() {
+    thread_local thread_data *data{nullptr};
+    if (!data) {
+      std::lock_guard lock{m_mutex};
+      auto &ptr = m_threads.emplace_back(std::make_unique<thread_data>());
+      ptr->id = static_cast<std::uint32_t>(m_threads.size() - 1);
+      data = ptr.get();
+    }
+    return *data;
+  }
+
+  static void _sample_hook(lua_State *L, lua_Debug *) {
+    auto &self = get();
+    if (!self.enabled()) return;
+
+    const auto now = clock::now();
+    auto &data = self._local();
+    // Samples from previous frames don't count (idle time in between)
+    const auto frame = self.m_frame.load(std::memory_order_relaxed);
+    const auto begin = data.last_frame == frame ? data.last_sample : now;
+    data.last_sample = now;
+    data.last_frame = frame;
+
+    lua_Debug ar;
+    if (!lua_getstack(L, 0, &ar) || !lua_getinfo(L, "Sn", &ar)) return;
+    const auto name = std::string{ar.name ? ar.name : "?"} + " (" +
+                      ar.short_src + ":" + std::to_string(ar.linedefined) +
+                      ")";
+    self.record("lua", self.intern(name), begin, now);
+  }
+
+private:
+  std::atomic<bool> m_enabled{false};
+  std::atomic<std::size_t> m_capture{0};
+  std::atomic<std::size_t> m_frame{0};
+  const clock::time_point m_epoch{clock::now()};
+
+  mutable std::mutex m_mutex;
+  std::vector<std::unique_ptr<thread_data>> m_threads;
+  std::unordered_set<std::string> m_names;
+};
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+// e.g. PROFILER_ZONE("registry", "get");
+#define PROFILER_ZONE(category, name)                                          \
+  const profiler::zone PROFILER_CONCAT(profiler_zone_, __LINE__)(category, name)
+
+[[nodiscard]] inline sol::table open_profiler(sol::this_state s) {
+  // In lua: entt.profiler.enable(true)
+
+  sol::state_view lua{s};
+  auto entt_module = lua["entt"].get_or_create<sol::table>();
+  auto module = entt_module["profiler"].get_or_create<sol::table>();
+
+  module.set_function("enable", [](bool enabled) {
+    profiler::get().enable(enabled);
+  });
+  module.set_function("enabled", [] { return profiler::get().enabled(); });
+  module.set_function("reset", [] { profiler::get().reset(); });
+  module.set_function("capture", [](std::size_t num_frames) {
+    profiler::get().capture(num_frames);
+  });
+  module.set_function("sample", [](int instructions, sol::this_state s) {
+    profiler::sample(s, instructions);
+  });
+  // { ["registry:get"] = { count = 10, time = 0.001 }, ... }
+  module.set_function("stats", [](sol::this_state s) {
+    sol::state_view lua{s};
+    auto result = lua.create_table();
+    for (const auto &[key, stats] : profiler::get().collect()) {
+      const auto name =
+        std::string{key.category} + ":" + std::string{key.name};
+      result[name] = lua.create_table_with(
+        "count", stats.count,
+        "time", std::chrono::duration<double>(stats.total).count());
+    }
+    return result;
+  });
+  module.set_function("write_trace", [](const std::string &path) {
+    return profiler::get().write_trace(path);
+  });
+
+  return entt_module;
+}
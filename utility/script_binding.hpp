@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include "profiler.hpp"
+#include "sol/sol.hpp"
+
+// Lifecycle hooks of scripts (systems and processes)
+enum class script_hook : std::uint8_t {
+  init,
+  update,
+  destroy,
+  // Processes only
+  succeeded,
+  failed,
+  aborted,
+
+  count
+};
+
+// Name of a hook (key in a script table)
+[[nodiscard]] constexpr std::string_view to_string(script_hook hook) {
+  switch (hook) {
+  case script_hook::init:
+    return "init";
+  case script_hook::update:
+    return "update";
+  case script_hook::destroy:
+    return "destroy";
+  case script_hook::succeeded:
+    return "succeeded";
+  case script_hook::failed:
+    return "failed";
+  case script_hook::aborted:
+    return "aborted";
+  default:
+    break;
+  }
+  return "";
+}
+
+// Script table (self) with its hooks, resolved once (on bind).
+// A missing hook costs a branch (bitmask) instead of a table lookup.
+// In lua: self.set_hook("update", f) reassigns (and re-resolves) a hook,
+// plain 'self.update = f' is not noticed.
+class script_binding {
+  static constexpr auto num_hooks = static_cast<std::size_t>(script_hook::count);
+  static_assert(num_hooks <= 8);
+
+  // Shared with set_hook (weakly), the binding itself might be moved around
+  // (e.g. component storage).
+  struct state {
+    sol::table self;
+    std::array<sol::function, num_hooks> hooks;
+    std::uint8_t mask{0};
+
+    void resolve(script_hook hook) {
+      const auto i = static_cast<std::size_t>(hook);
+      const auto bit = static_cast<std::uint8_t>(1u << i);
+      if (const sol::object f = self[to_string(hook)];
+          f.get_type() == sol::type::function) {
+        hooks[i] = f.as<sol::function>();
+        mask |= bit;
+      } else {
+        hooks[i] = sol::function{};
+        mask &= ~bit;
+      }
+    }
+    void resolve_all() {
+      for (std::size_t i = 0; i < num_hooks; ++i)
+        resolve(static_cast<script_hook>(i));
+    }
+  };
+
+public:
+  script_binding() = default;
+  explicit script_binding(sol::table self)
+      : m_state{std::make_shared<state>()} {
+    m_state->self = std::move(self);
+    m_state->resolve_all();
+
+    m_state->self.set_function(
+      "set_hook", [weak = std::weak_ptr<state>{m_state}](
+                    const std::string_view name, const sol::object &f) {
+        auto s = weak.lock();
+        if (!s) return;
+        s->self[name] = f;
+        for (std::size_t i = 0; i < num_hooks; ++i) {
+          if (const auto hook = static_cast<script_hook>(i);
+              to_string(hook) == name) {
+            s->resolve(hook);
+          }
+        }
+      });
+  }
+
+  [[nodiscard]] bool valid() const { return m_state && m_state->self.valid(); }
+
+  [[nodiscard]] sol::table &self() {
+    assert(m_state);
+    return m_state->self;
+  }
+  [[nodiscard]] const sol::table &self() const {
+    assert(m_state);
+    return m_state->self;
+  }
+
+  [[nodiscard]] bool has(script_hook hook) const {
+    return m_state && (m_state->mask >> static_cast<std::size_t>(hook)) & 1u;
+  }
+  // Calls hook(self, args...) if the script defines it
+  template <typename... Args>
+  void call(script_hook hook, Args &&...args) const {
+    if (!has(hook)) return;
+    PROFILER_ZONE("hook", to_string(hook));
+    m_state->hooks[static_cast<std::size_t>(hook)](m_state->self,
+                                                   std::forward<Args>(args)...);
+  }
+
+  // Re-resolves all hooks (after a script changed its table directly)
+  void rebind() {
+    if (m_state) m_state->resolve_all();
+  }
+  // Drops references without touching the lua state
+  void abandon() {
+    if (!m_state) return;
+    m_state->self.abandon();
+    for (auto &f : m_state->hooks)
+      f.abandon();
+    m_state->mask = 0;
+  }
+
+private:
+  std::shared_ptr<state> m_state;
+};
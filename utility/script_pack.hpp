@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include "mapped_file.hpp"
+#include "sol/sol.hpp"
+
+// Pack of precompiled scripts (produced by tools/luapack at build time):
+//  header | entries (sorted by name) | names | bytecode
+namespace script_pack_format {
+
+inline constexpr char magic[4]{'L', 'P', 'A', 'K'};
+inline constexpr std::uint32_t version{1};
+
+struct header {
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t lua_version; // LUA_VERSION_NUM, bytecode is not portable
+  std::uint32_t count;
+};
+struct entry {
+  std::uint32_t name_offset;
+  std::uint32_t name_size;
+  std::uint32_t data_offset;
+  std::uint32_t data_size;
+  std::int64_t mtime; // Of the source file (see get_file_time)
+};
+
+// Opaque timestamp, only comparable with values from the same platform.
+// Returns -1 if a file does not exist.
+[[nodiscard]] inline std::int64_t
+get_file_time(const std::filesystem::path &p) {
+  std::error_code ec;
+  const auto t = std::filesystem::last_write_time(p, ec);
+  return ec ? -1 : static_cast<std::int64_t>(t.time_since_epoch().count());
+}
+
+} // namespace script_pack_format
+
+// Loads scripts from a memory mapped pack of bytecode.
+// A script that is not in the pack, or whose source file is newer than its
+// bytecode, is loaded from the source file.
+// Keep the pack alive as long as a lua state that uses the package loader.
+class script_pack {
+  using header = script_pack_format::header;
+  using entry = script_pack_format::entry;
+
+public:
+  script_pack() = default;
+  explicit script_pack(const std::filesystem::path &p) { open(p); }
+
+  bool open(const std::filesystem::path &p) {
+    m_entries = nullptr;
+    m_count = 0;
+    if (!m_file.open(p)) return false;
+    if (!_validate()) {
+      m_file.close();
+      return false;
+    }
+    const auto *h = reinterpret_cast<const header *>(m_file.data());
+    m_entries = reinterpret_cast<const entry *>(m_file.data() + sizeof(header));
+    m_count = h->count;
+    return true;
+  }
+  [[nodiscard]] bool is_open() const { return m_file.data() != nullptr; }
+  [[nodiscard]] std::size_t size() const { return m_count; }
+  [[nodiscard]] bool contains(std::string_view filename) const {
+    return _find(filename) != nullptr;
+  }
+
+  // Same as luaL_loadfile (chunk or an error message on the stack).
+  int load(lua_State *L, const std::string &filename) const {
+    if (const auto *e = _find(filename);
+        e && script_pack_format::get_file_time(filename) <= e->mtime) {
+      const auto chunk_name = "@" + filename;
+      return luaL_loadbuffer(L, m_file.data() + e->data_offset, e->data_size,
+                             chunk_name.c_str());
+    }
+    return luaL_loadfile(L, filename.c_str());
+  }
+  // Same as sol::state_view::script_file
+  sol::protected_function_result script_file(sol::state_view lua,
+                                             const std::string &filename) const {
+    lua_State *L = lua.lua_state();
+    if (load(L, filename) != 0) {
+      std::string what{lua_tostring(L, -1)};
+      lua_pop(L, 1);
+      throw sol::error{std::move(what)};
+    }
+    sol::protected_function chunk{L, -1};
+    lua_pop(L, 1);
+    auto result = chunk();
+    if (!result.valid()) {
+      sol::error err = result;
+      throw err;
+    }
+    return result;
+  }
+
+  // require("lua.foo") loads "lua/foo.lua" from the pack.
+  // Installed right after package.preload searcher, before the source one.
+  void add_package_loader(sol::state_view lua) const {
+    lua_State *L = lua.lua_state();
+    lua_getglobal(L, "package");
+#if LUA_VERSION_NUM >= 502
+    lua_getfield(L, -1, "searchers");
+#else
+    lua_getfield(L, -1, "loaders");
+#endif
+    assert(lua_type(L, -1) == LUA_TTABLE);
+    const auto size = static_cast<int>(lua_rawlen(L, -1));
+    for (auto i = size; i >= 2; --i) {
+      lua_rawgeti(L, -1, i);
+      lua_rawseti(L, -2, i + 1);
+    }
+    lua_pushlightuserdata(L, const_cast<script_pack *>(this));
+    lua_pushcclosure(L, &script_pack::_searcher, 1);
+    lua_rawseti(L, -2, 2);
+    lua_pop(L, 2);
+  }
+
+private:
+  [[nodiscard]] bool _validate() const {
+    const auto size = m_file.size();
+    if (size < sizeof(header)) return false;
+    header h;
+    std::memcpy(&h, m_file.data(), sizeof(header));
+    if (std::memcmp(h.magic, script_pack_format::magic, sizeof(h.magic)) != 0 ||
+        h.version != script_pack_format::version ||
+        h.lua_version != LUA_VERSION_NUM) {
+      return false;
+    }
+    if (sizeof(header) + std::size_t{h.count} * sizeof(entry) > size)
+      return false;
+    const auto *entries =
+      reinterpret_cast<const entry *>(m_file.data() + sizeof(header));
+    return std::all_of(entries, entries + h.count, [size](const entry &e) {
+      return std::size_t{e.name_offset} + e.name_size <= size &&
+             std::size_t{e.data_offset} + e.data_size <= size;
+    });
+  }
+  [[nodiscard]] std::string_view _name(const entry &e) const {
+    return {m_file.data() + e.name_offset, e.name_size};
+  }
+  [[nodiscard]] const entry *_find(std::string_view filename) const {
+    const auto *last = m_entries + m_count;
+    const auto *it = std::lower_bound(
+      m_entries, last, filename,
+      [this](const entry &e, std::string_view name) { return _name(e) < name; });
+    return it != last && _name(*it) == filename ? it : nullptr;
+  }
+
+  static int _searcher(lua_State *L) {
+    const auto *self =
+      static_cast<const script_pack *>(lua_touserdata(L, lua_upvalueindex(1)));
+    std::string filename{luaL_checkstring(L, 1)};
+    std::replace(filename.begin(), filename.end(), '.', '/');
+    filename += ".lua";
+
+    if (!self->contains(filename)) {
+      lua_pushfstring(L, "\n\tno entry '%s' in script pack", filename.c_str());
+      return 1;
+    }
+    if (self->load(L, filename) != 0) return lua_error(L);
+    lua_pushstring(L, filename.c_str());
+    return 2;
+  }
+
+private:
+  mapped_file m_file;
+  const entry *m_entries{nullptr};
+  std::size_t m_count{0};
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel (Varghese & Lauck), 64 slots per level.
+// advance() touches only slots of elapsed ticks, so its cost depends on the
+// number of due entries, not on the number of scheduled ones.
+// With the default resolution (1 ms) and 4 levels, max delay is ~4.6 hours
+// (longer delays are clamped by re-scheduling on cascade).
+template <typename T, std::size_t NumLevels = 4> class timer_wheel {
+  static constexpr std::size_t slot_bits = 6;
+  static constexpr std::size_t num_slots = std::size_t{1} << slot_bits;
+  static constexpr std::uint64_t slot_mask = num_slots - 1;
+
+public:
+  using duration = std::chrono::duration<float>;
+
+  explicit timer_wheel(duration resolution = std::chrono::milliseconds{1})
+      : m_resolution{resolution} {}
+
+  [[nodiscard]] std::size_t size() const { return m_size; }
+  [[nodiscard]] bool empty() const { return m_size == 0; }
+  // Time elapsed since construction (multiple of resolution)
+  [[nodiscard]] duration now() const {
+    return m_resolution * static_cast<float>(m_now);
+  }
+
+  // Entry is going to be due after (at least) a given delay, zero delay
+  // means the next tick.
+  void schedule(T value, duration delay) {
+    const auto ticks = static_cast<std::uint64_t>(
+      std::ceil(std::max(delay.count(), 0.0f) / m_resolution.count()));
+    _insert({m_now + std::max(ticks, std::uint64_t{1}), std::move(value)});
+    ++m_size;
+  }
+
+  // Calls on_due(T &&) for every entry whose deadline has been reached.
+  template <typename Func> void advance(duration dt, Func &&on_due) {
+    m_remainder += dt;
+    while (m_remainder >= m_resolution) {
+      m_remainder -= m_resolution;
+      _tick(on_due);
+    }
+  }
+
+  // Removes all entries, calls func(T &&) for each of them.
+  template <typename Func> void drain(Func &&func) {
+    for (auto &level : m_levels) {
+      for (auto &slot : level) {
+        for (auto &entry : slot)
+          func(std::move(entry.value));
+        slot.clear();
+      }
+    }
+    m_size = 0;
+  }
+  void clear() {
+    drain([](T &&) {});
+  }
+
+private:
+  struct entry {
+    std::uint64_t deadline;
+    T value;
+  };
+
+  void _insert(entry &&e) {
+    const auto delta = e.deadline > m_now ? e.deadline - m_now : 0;
+    std::size_t level{0};
+    while (level + 1 < NumLevels &&
+           delta >= (std::uint64_t{1} << (slot_bits * (level + 1)))) {
+      ++level;
+    }
+    const auto index = (e.deadline >> (slot_bits * level)) & slot_mask;
+    m_levels[level][index].push_back(std::move(e));
+  }
+  // Moves entries of a higher level slot to lower levels
+  void _cascade(std::size_t level, std::size_t index) {
+    std::swap(m_levels[level][index], m_scratch);
+    for (auto &e : m_scratch)
+      _insert(std::move(e));
+    m_scratch.clear();
+  }
+
+  template <typename Func> void _tick(Func &on_due) {
+    ++m_now;
+    for (std::size_t level = 1; level < NumLevels; ++level) {
+      const auto mask = (std::uint64_t{1} << (slot_bits * level)) - 1;
+      if ((m_now & mask) != 0) break;
+      _cascade(level, (m_now >> (slot_bits * level)) & slot_mask);
+    }
+
+    auto &slot = m_levels[0][m_now & slot_mask];
+    if (slot.empty()) return;
+
+    // on_due might schedule new entries
+    std::swap(slot, m_due);
+    m_size -= m_due.size();
+    for (auto &e : m_due) {
+      if (e.deadline <= m_now) {
+        on_due(std::move(e.value));
+      } else {
+        _insert(std::move(e));
+        ++m_size;
+      }
+    }
+    m_due.clear();
+  }
+
+private:
+  duration m_resolution;
+  duration m_remainder{0};
+  std::uint64_t m_now{0};
+  std::size_t m_size{0};
+
+  std::array<std::array<std::vector<entry>, num_slots>, NumLevels> m_levels;
+  std::vector<entry> m_scratch;
+  std::vector<entry> m_due;
+};
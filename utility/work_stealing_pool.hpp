@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Fixed set of threads, running batches of tasks (indices) split into
+// ranges. Every thread has its own queue (taken from the back), an idle
+// thread steals ranges from the front of others, so uneven tasks are
+// balanced. The calling thread takes part in a batch (queue 0).
+class work_stealing_pool {
+  struct range {
+    std::size_t begin;
+    std::size_t end;
+  };
+  struct queue {
+    std::mutex mutex;
+    std::deque<range> ranges;
+  };
+
+public:
+  // Threads in addition to the calling one (0 = run batches serially)
+  explicit work_stealing_pool(std::size_t num_threads)
+      : m_queues(num_threads + 1) {
+    m_threads.reserve(num_threads);
+    for (std::size_t i = 1; i <= num_threads; ++i)
+      m_threads.emplace_back(&work_stealing_pool::_run, this, i);
+  }
+  work_stealing_pool(const work_stealing_pool &) = delete;
+  ~work_stealing_pool() {
+    {
+      std::lock_guard lock{m_mutex};
+      m_stop = true;
+    }
+    m_start.notify_all();
+    for (auto &thread : m_threads)
+      thread.join();
+  }
+
+  work_stealing_pool &operator=(const work_stealing_pool &) = delete;
+
+  [[nodiscard]] static std::size_t default_concurrency() {
+    const auto n = std::thread::hardware_concurrency();
+    return n > 1 ? n - 1 : 0;
+  }
+
+  // Threads, including the calling one
+  [[nodiscard]] std::size_t size() const { return m_queues.size(); }
+
+  // Calls task(i) for every i in [0, count) on any thread, and local() on
+  // the calling thread only (before it joins the others). Blocks until all
+  // tasks are done, rethrows the first exception of a task.
+  template <typename Task, typename Local>
+  void run(std::size_t count, Task &&task, Local &&local) {
+    using task_type = std::remove_reference_t<Task>;
+    m_task = [](void *ctx, std::size_t i) {
+      (*static_cast<task_type *>(ctx))(i);
+    };
+    m_context = const_cast<void *>(static_cast<const void *>(&task));
+    m_remaining.store(count, std::memory_order_relaxed);
+    _distribute(count);
+    if (count > 0) {
+      {
+        std::lock_guard lock{m_mutex};
+        ++m_batch;
+      }
+      m_start.notify_all();
+    }
+
+    // Tasks refer to the caller's state, so they are done before throwing
+    std::exception_ptr local_error;
+    try {
+      local();
+    } catch (...) {
+      local_error = std::current_exception();
+    }
+    _work(0);
+    // Ranges stolen by others might still be running
+    while (m_remaining.load(std::memory_order_acquire) > 0)
+      std::this_thread::yield();
+
+    if (local_error) std::rethrow_exception(local_error);
+    if (auto error = std::exchange(m_error, nullptr); error)
+      std::rethrow_exception(error);
+  }
+  template <typename Task> void run(std::size_t count, Task &&task) {
+    run(count, std::forward<Task>(task), [] {});
+  }
+
+private:
+  void _distribute(std::size_t count) {
+    // A few ranges per thread, so there is something left to steal
+    const auto num_ranges = std::min(count, m_queues.size() * 4);
+    if (num_ranges == 0) return;
+    const auto grain = (count + num_ranges - 1) / num_ranges;
+    std::size_t index{0};
+    for (std::size_t begin = 0; begin < count; begin += grain) {
+      auto &q = m_queues[index++ % m_queues.size()];
+      std::lock_guard lock{q.mutex};
+      q.ranges.push_back({begin, std::min(begin + grain, count)});
+    }
+  }
+
+  [[nodiscard]] bool _pop(std::size_t index, range &out) {
+    auto &q = m_queues[index];
+    std::lock_guard lock{q.mutex};
+    if (q.ranges.empty()) return false;
+    out = q.ranges.back();
+    q.ranges.pop_back();
+    return true;
+  }
+  [[nodiscard]] bool _steal(std::size_t thief, range &out) {
+    for (std::size_t i = 1; i < m_queues.size(); ++i) {
+      auto &q = m_queues[(thief + i) % m_queues.size()];
+      std::lock_guard lock{q.mutex};
+      if (q.ranges.empty()) continue;
+      out = q.ranges.front();
+      q.ranges.pop_front();
+      return true;
+    }
+    return false;
+  }
+
+  void _work(std::size_t index) {
+    range r{};
+    while (_pop(index, r) || _steal(index, r)) {
+      try {
+        for (auto i = r.begin; i < r.end; ++i)
+          m_task(m_context, i);
+      } catch (...) {
+        std::lock_guard lock{m_mutex};
+        if (!m_error) m_error = std::current_exception();
+      }
+      m_remaining.fetch_sub(r.end - r.begin, std::memory_order_acq_rel);
+    }
+  }
+
+  void _run(std::size_t index) {
+    std::size_t batch{0};
+    while (true) {
+      {
+        std::unique_lock lock{m_mutex};
+        m_start.wait(lock, [&] { return m_stop || m_batch != batch; });
+        if (m_stop) return;
+        batch = m_batch;
+      }
+      _work(index);
+    }
+  }
+
+private:
+  std::vector<queue> m_queues;
+  std::vector<std::thread> m_threads;
+
+  // Current batch, set before its ranges are pushed (under queue mutexes)
+  void (*m_task)(void *, std::size_t){nullptr};
+  void *m_context{nullptr};
+  std::atomic<std::size_t> m_remaining{0};
+  std::exception_ptr m_error;
+
+  std::mutex m_mutex;
+  std::condition_variable m_start;
+  std::size_t m_batch{0};
+  bool m_stop{false};
+};